@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+#include <arpa/inet.h>
+#include <array>
+#include <chrono>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "md/itch/udp_receiver.h"
+#include "md/itch/uring_receiver.h"
+
+using namespace zeus::md::itch;
+
+namespace
+{
+  constexpr char const group[] = "239.192.0.78";
+  constexpr char const loopback[] = "127.0.0.1";
+
+  /* A typical MoldUDP64 packet at the open carries a handful of messages */
+  constexpr std::size_t packet_size{256};
+
+  /* Loopback multicast can still drop a datagram, so give up on a burst rather than wait for it forever */
+  constexpr std::chrono::seconds burst_timeout{1};
+
+  /* Publishes bursts of datagrams onto the multicast group over loopback */
+  class publisher
+  {
+  public:
+    explicit publisher(uint16_t port) : _fd(::socket(AF_INET, SOCK_DGRAM, 0))
+    {
+      in_addr interface{};
+      ::inet_pton(AF_INET, loopback, &interface);
+      ::setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface));
+
+      _destination.sin_family = AF_INET;
+      _destination.sin_port = htons(port);
+      ::inet_pton(AF_INET, group, &_destination.sin_addr);
+    }
+
+    ~publisher() { ::close(_fd); }
+
+    void burst(std::size_t packets)
+    {
+      for (std::size_t index = 0; index < packets; ++index)
+      {
+        ::sendto(_fd, _packet.data(), _packet.size(), 0, reinterpret_cast<sockaddr const *>(&_destination),
+                 sizeof(_destination));
+      }
+    }
+
+  private:
+    int _fd;
+    sockaddr_in _destination{};
+    std::array<std::byte, packet_size> _packet{};
+  };
+
+  /**
+   * Publish a burst and drain it. Sending is timed too, since with io_uring part of the receive work happens as the
+   * datagram is delivered, and leaving it out would flatter it. The cost of sending is the same for both receivers.
+   */
+  template<typename Receiver>
+  void receive_bursts(benchmark::State &state, std::size_t depth)
+  {
+    std::size_t const burst = static_cast<std::size_t>(state.range(0));
+
+    try
+    {
+      Receiver receiver{group, 0, loopback, depth};
+      publisher sender{receiver.port()};
+
+      for (auto _ : state)
+      {
+        sender.burst(burst);
+        auto const deadline = std::chrono::steady_clock::now() + burst_timeout;
+        for (std::size_t received = 0; received < burst;)
+        {
+          std::span<std::byte const> packet = receiver.receive();
+          benchmark::DoNotOptimize(packet.data());
+          if (!packet.empty())
+          {
+            ++received;
+          }
+          /* Only look at the clock while we are waiting, so it stays out of the measurement when packets are flowing */
+          else if (__unlikely(std::chrono::steady_clock::now() > deadline))
+          {
+            state.SkipWithError("Timed out waiting for a burst. A datagram was probably dropped.");
+            return;
+          }
+        }
+      }
+
+      state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * burst));
+    }
+    catch (std::runtime_error const &error)
+    {
+      state.SkipWithError(error.what());
+    }
+  }
+
+  void recvmmsg_bursts(benchmark::State &state)
+  {
+    receive_bursts<udp_receiver>(state, udp_receiver::default_batch_size);
+  }
+
+  void io_uring_bursts(benchmark::State &state)
+  {
+    receive_bursts<uring_receiver>(state, uring_receiver::default_buffer_count);
+  }
+}
+
+BENCHMARK(recvmmsg_bursts)->Arg(1)->Arg(8)->Arg(64);
+BENCHMARK(io_uring_bursts)->Arg(1)->Arg(8)->Arg(64);
\ No newline at end of file
@@ -1,86 +1,204 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <span>
+#include <type_traits>
 #include <utility>
-#include <unordered_map>
+#include <vector>
 
 #include "core/order.h"
 #include "math/fastmod.h"
 #include "md/level.h"
+#include "md/level_bitmap.h"
+#include "md/order_map.h"
+#include "md/order_pool.h"
+#include "md/tick_table.h"
 #include "md/types.h"
+#include "thread/seqlock.h"
+#include "thread/spsc_circular_buffer.h"
 
-/** A limit order book. As a performance experiment, it has a maximum of 64 levels.
+/** A limit order book. Each side keeps a window of levels behind the touch that is indexed directly by price, and spills
+ *  any level outside of it into a sparse, ordered map.
  *
- *  This book is only performant for liquid instruments. Sparse books will suffer may penalty when the spread moves. */
+ *  Nothing rests on the far side of the touch, so the window sits mostly behind it. It recenters when the touch drifts out
+ *  of the half nearest the spread, so liquid instruments almost never leave the directly indexed path. Wide or illiquid
+ *  instruments stay correct, but will pay for the map when trading away from the touch. */
 namespace zeus::md
 {
-  /* Since the book is currently stateless (L2), we do not need any more order information. */
+  class snapshot_reader;
+  class snapshot_writer;
+
+  /* The price (in ticks) and side of the level an order rests in, and its node in the level's queue. Levels move when the
+   * window recenters, so we cannot hold on to their address. The open quantity lives in the node. The tick index and
+   * side share a word, so an entry in the order map is 16 bytes with its key and four fit in a cache line. */
   struct order_info
   {
+    /* The largest tick index that fits alongside the side bit */
+    static constexpr std::size_t max_ticks{std::numeric_limits<uint32_t>::max() >> 1};
+
     order_info() = default;
 
-    order_info(md::level *level, core::quantity_t qty) : _level(level), _qty(qty)
+    order_info(std::size_t ticks, core::order_side side, order_handle_t node)
+      : _level(static_cast<uint32_t>(ticks << 1 | (side == core::order_side::SELL))), _node(node)
+    {
+      utility::zassert(ticks <= max_ticks, "Price is too far up the tick ladder.");
+    }
+
+    /** The price of the level, in ticks */
+    [[nodiscard]] std::size_t ticks() const noexcept { return _level >> 1; }
+
+    /***/
+    [[nodiscard]] core::order_side side() const noexcept
     {
+      return (_level & 1) != 0 ? core::order_side::SELL : core::order_side::BUY;
     }
 
-    md::level *_level;
-    core::quantity_t _qty;
+    /** \brief The tick index of the level, shifted up past a bit that is set for the sell side */
+    uint32_t _level{0};
+    order_handle_t _node{invalid_order_handle};
+  };
+
+  static_assert(sizeof(order_info) == 8);
+
+  /* The best bid and offer as last published by the book. Empty sides have an invalid price and no quantity. */
+  struct quote
+  {
+    core::price_t _bid_price{core::invalid_price};
+    core::quantity_t _bid_quantity{0};
+    core::price_t _ask_price{core::invalid_price};
+    core::quantity_t _ask_quantity{0};
+
+    /** \brief Counts the quotes the book has published, starting at 1 */
+    uint64_t _sequence{0};
+
+    /** \brief The ITCH timestamp of the change, in nanoseconds since midnight */
+    uint64_t _timestamp{0};
   };
 
+  /* A change to the total quantity of a level. Replaying them in sequence rebuilds the depth of the book. */
+  struct level_update
+  {
+    /** \brief Counts the updates from this book, starting at 1. A gap means the ring was full and updates were lost. */
+    uint64_t _sequence;
+
+    core::price_t _price;
+
+    /** \brief The quantity now resting at the level. Zero means the level is gone. */
+    core::quantity_t _quantity;
+
+    /** \brief Whatever the owner of the book uses to tell instruments apart, e.g. the locate */
+    uint32_t _instrument;
+
+    core::order_side _side;
+  };
+
+  static_assert(std::is_trivially_copyable_v<level_update> && sizeof(level_update) == 32);
+
+  /* Room for 64k level updates */
+  using level_update_ring = thread::spsc_circular_buffer<level_update, 1 << 21>;
+
   class book
   {
   private:
+    static constexpr std::size_t _default_order_capacity{1024};
+    static constexpr std::size_t _default_window_levels{64};
+
     /* We will represent the bid/ask side of a book separately */
-    static constexpr std::size_t _max_levels{64};
-    using book_side_t = std::pair<std::size_t, std::array<md::level, _max_levels>>;
+    struct book_side
+    {
+      /** \brief The price of the best level in ticks. Empty sides are represented by the numerical min/max. */
+      std::size_t _top;
+
+      /** \brief The price in ticks of the first level in the window */
+      std::size_t _base{0};
+
+      /** \brief The levels closest to the touch, indexed by their distance from the base */
+      std::vector<md::level> _window;
+
+      /** \brief Which levels of the window have orders resting, so we can jump straight to the next best level */
+      md::level_bitmap _occupied;
+
+      /** \brief A buffer the same size as the window, so recentering never needs to allocate a new window */
+      std::vector<md::level> _scratch;
+
+      /** \brief Every non-empty level outside of the window */
+      std::map<std::size_t, md::level> _spill;
+    };
 
   public:
-    book() = default;
+    book() : book(md::tick_table{core::price_t::max()})
+    {
+    }
 
     ~book() = default;
 
-    /***/
-    book(core::price_t tick_size);
+    /**
+     * Rebuild a book exactly as it was saved, including the queue position of every order
+     *
+     * @param reader The snapshot
+     * @param offset Where the book was saved, as returned by save()
+     */
+    book(md::snapshot_reader const &reader, uint64_t offset);
+
+    /**
+     * @param ticks The tick size regime of the instrument. A single tick size converts implicitly.
+     * @param order_capacity The number of orders to preallocate storage for, e.g. the previous day's peak
+     * @param window_levels The number of levels per side that are indexed directly. Tune it to the instrument's width,
+     *   up to level_bitmap::max_size.
+     */
+    book(md::tick_table const &ticks, std::size_t order_capacity = _default_order_capacity,
+         std::size_t window_levels = _default_window_levels);
 
     /**
      * Add an order into the LOB
      *
      * @param order The order to add to the book
+     * @returns Whether the top of book changed
      */
-    void add(order_add const &order);
+    bool add(order_add const &order);
 
     /**
      * Cancel an order in the LOB
      *
      * @param order The order to cancel from the book
+     * @returns Whether the top of book changed
      */
-    void cancel(order_canceled const &order);
+    bool cancel(order_canceled const &order);
 
     /**
      * Remove an order from the LOB
      *
      * @param order The order to cancel from the book
+     * @returns Whether the top of book changed
      */
-    void remove(order_removed const &order);
+    bool remove(order_removed const &order);
 
     /**
      * Amend one order to another in the LOB. This implementation is not thread safe.
      *
      * @param order The order that has been amended
+     * @returns Whether the top of book changed
      */
-    void replace(order_replaced const &order);
+    bool replace(order_replaced const &order);
 
     /**
      * Execute an order in the LOB
      *
      * @param order The order that has been executed
+     * @returns Whether the top of book changed
      */
-    void execute(order_executed const &order);
+    bool execute(order_executed const &order);
 
     /**
      * Execute an order in the LOB at a specific price
+     *
+     * @returns Whether the top of book changed
      */
-    void execute_with_price(order_executed_with_price const &order);
+    bool execute_with_price(order_executed_with_price const &order);
 
     /**
      * Get the best bid price/qty
@@ -92,25 +210,151 @@ namespace zeus::md
      */
     std::pair<core::price_t, core::quantity_t> best_ask() const;
 
+    /**
+     * Get the best levels of one side of the book, best first. Only occupied levels are visited, so this costs the same
+     * however sparse the book is.
+     *
+     * @param side The side of the book
+     * @param levels The most levels to fill in
+     * @param out Filled in with the price and total quantity of each level
+     * @returns The number of levels filled in, which is fewer than asked for if the side is shallower or out is smaller
+     */
+    std::size_t depth(core::order_side side, std::size_t levels,
+                      std::span<std::pair<core::price_t, core::quantity_t>> out) const;
+
+    /**
+     * Publish the best bid and offer for other threads to read. Only the thread that updates the book may call this.
+     *
+     * @param timestamp When the top of book changed
+     */
+    void publish(uint64_t timestamp);
+
+    /** The last quote published, which any thread may load from */
+    [[nodiscard]] thread::seqlock<md::quote> const &published() const noexcept { return _published; }
+
+    /**
+     * Append the state of the book to a snapshot: both sides, the queue of every level and the order map. The update
+     * stream is not saved.
+     *
+     * @returns The offset to restore the book from
+     */
+    uint64_t save(md::snapshot_writer &writer) const;
+
+    /**
+     * Write a level_update to a ring for every change to the quantity of a level, from here on. Updates are dropped
+     * while the ring is full.
+     *
+     * @param ring Where to write the updates, or nullptr to stop. It must outlive the book.
+     * @param instrument Stamped on every update, so several books can share a ring
+     */
+    void stream_to(level_update_ring *ring, uint32_t instrument = 0) noexcept
+    {
+      _updates = ring;
+      _instrument = instrument;
+    }
+
+    /**
+     * Get the position of an order in the queue of its level
+     *
+     * @param order_id The order to locate
+     * @returns The number of orders and the quantity resting ahead of the order
+     */
+    std::pair<std::size_t, core::quantity_t> queue_position(core::ordid_t order_id) const;
+
+    /**
+     * Pull the book's entry for an order into cache ahead of processing a message for it. The feed does this for every
+     * order update as it dispatches it.
+     *
+     * @param order_id The order that is about to be updated
+     */
+    void prefetch(core::ordid_t order_id) const noexcept
+    {
+      _order_level_mapping.prefetch(order_id);
+    }
+
+    /** The number of orders currently resting in the book */
+    [[nodiscard]] std::size_t live_orders() const noexcept { return _order_level_mapping.size(); }
+
+    /** The highest number of orders that have rested in the book at once. Use it to size tomorrow's book. */
+    [[nodiscard]] std::size_t peak_orders() const noexcept { return _peak_orders; }
+
+    /**
+     * The number of cancels, removes, executions and replaces that were ignored because the book never saw the order,
+     * e.g. because it was added before the book started following the instrument
+     */
+    [[nodiscard]] std::size_t unknown_orders() const noexcept { return _unknown_orders; }
+
   private:
-    /** If quantity is executed or removed, we need to check if the spread price has moved */
-    void _resolve_book_side(core::order_side side, order_info const &info);
+    /** If quantity is executed or removed, we need to check if the spread price has moved. Returns whether the top of
+     *  book changed. */
+    bool _resolve_book_side(order_info const &info);
 
-    /** Determine which side a level belongs to */
-    core::order_side _level_to_side(md::level const &level) const;
+    /** Count an update for an order we do not hold. It cannot move the top of book. */
+    [[using gnu: cold, noinline]] bool _unknown_order() noexcept;
+
+    /** Unlink a fully filled or removed order from its level and return its node and map entry */
+    void _release_order(core::ordid_t order_id, order_info const &info);
+
+    /** Find the level for a price, creating it in the spill map if it is outside of the window */
+    md::level &_level(book_side &side, std::size_t ticks);
+
+    /** Find an existing level for a price */
+    md::level const &_level(book_side const &side, std::size_t ticks) const;
+
+    /** Write the quantity now resting at a price to the update stream */
+    void _stream(core::order_side side, std::size_t ticks);
+
+    /** Whether a price sits in the half of the window nearest the spread, i.e. whether the window is well placed for it */
+    static bool _is_central(book_side const &side, core::order_side order_side, std::size_t ticks) noexcept;
+
+    /** Move the window so that a price sits a quarter of the way in from the edge nearest the spread */
+    [[using gnu: cold, noinline]] static void _recenter(book_side &side, core::order_side order_side, std::size_t ticks);
+
+    /***/
+    book_side &_side(core::order_side side) noexcept
+    {
+      return _book[math::signof(static_cast<int64_t>(side))];
+    }
+
+    /***/
+    book_side const &_side(core::order_side side) const noexcept
+    {
+      return _book[math::signof(static_cast<int64_t>(side))];
+    }
 
   private:
     /** \brief Both side of the book glued together in an array */
-    std::array<book_side_t, 2> _book;
+    std::array<book_side, 2> _book;
 
-    /** \brief To use the price as an index into the book, we store the tick size optimised for modulo
-     *
-     *  TODO(jhannah): Need to support variable tick sizes.. Annoying, but I have a plan. */
-    math::lemire_fastmod _tick_size{std::numeric_limits<int64_t>::max()};
+    /** \brief To use the price as an index into the book, we store the tick sizes optimised for division */
+    md::tick_table _ticks;
+
+    /** \brief The storage for every order resting in the book */
+    md::order_pool _orders{};
+
+    /** \brief A mapping from order ID to the level it belongs to. Entries are erased once the order leaves the book, so
+     *  together with the pool, memory stays flat for the session. */
+    md::order_map<md::order_info> _order_level_mapping{};
+
+    /** \brief The high watermark of live orders */
+    std::size_t _peak_orders{0};
+
+    /** \brief Updates ignored because the order was not in the book */
+    std::size_t _unknown_orders{0};
+
+    /** \brief Where level changes are streamed to, if anywhere */
+    level_update_ring *_updates{nullptr};
+
+    /** \brief The number of level updates streamed so far */
+    uint64_t _update_sequence{0};
+
+    /***/
+    uint32_t _instrument{0};
+
+    /** \brief The number of quotes published so far */
+    uint64_t _quote_sequence{0};
 
-    /** \brief A mapping from client order ID to the level it belongs to.
-     *  TODO(jhannah): Write your own hash map, optimised for this use case.
-     *  TODO(jhannah): For the sake of performance, we do not delete from the map. Is this scalable? */
-    std::unordered_map<core::clordid_t, md::order_info> _order_level_mapping{};
+    /** \brief The top of book, for readers on other threads. It has a cache line to itself. */
+    thread::seqlock<md::quote> _published{};
   };
 }
\ No newline at end of file
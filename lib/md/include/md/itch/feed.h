@@ -1,209 +1,790 @@
 #pragma once
 
 #include "md/book.h"
+#include "md/snapshot.h"
 #include "md/types.h"
+#include "md/itch/listener.h"
+#include "md/itch/receiver.h"
+#include "md/itch/symbol_directory.h"
+#include "md/itch/trading_state.h"
 #include "md/itch/types.h"
 #include "system/utilities.h"
 
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <filesystem>
+#include <limits>
 #include <memory>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace zeus::md::itch
 {
-  /* A very simple implementation of an ITCH feedhandler that will build a book and return whether it has updated */
-  /** TODO(jhannah): Define a concept */
-  template<typename Receiver>
+  /**
+   * A very simple implementation of an ITCH feedhandler that will build a book and return whether it has updated.
+   * Anything else the listener subscribes to is passed on as it goes by.
+   */
+  template<receiver Receiver, typename Listener = null_listener>
   class feed {
+  private:
+    static constexpr std::size_t _default_order_capacity{64};
+
   public:
-    feed(std::unique_ptr<Receiver> receiver)
-    : _receiver(std::move(receiver))
+    /**
+     * @param receiver The stream to read messages from
+     * @param order_capacity The number of orders to preallocate storage for in each book
+     * @param listener Told about the events it has hooks for
+     */
+    feed(std::unique_ptr<Receiver> receiver, std::size_t order_capacity = _default_order_capacity,
+         Listener listener = Listener{})
+    : _order_capacity(order_capacity), _receiver(std::move(receiver)), _listener(std::move(listener))
     {
-      /* Assume here that we are only dealing with stocks listed > 1USD */
-      std::fill(_books.begin(), _books.end(), core::price_t::from_underlying(math::pow(10, 6)));
+      /* Books are only built once a locate becomes active, and the arena grows a chunk at a time as they are */
+      _changed.reserve(_num_books);
+
+      /* Until something is subscribed to, every locate is wanted */
+      _wanted.set();
     }
 
-    /***/
+    /**
+     * Handle the next message
+     *
+     * @returns Whether the top of book changed
+     */
     bool poll()
     {
-      constexpr size_t maximum_size = 50;
-      std::byte buffer[maximum_size]{};
-
-      /* Read the header */
-      _receiver.read(buffer, sizeof(message_header));
-      message_header const& header = *reinterpret_cast<message_header const*>(buffer);
-
-      /* Could be more concise with macros/templates, but I personally prefer it to be obviously laid out */
-      switch(header._type)
-      {
-        case message_type::ORDER_CANCEL_MESSAGE:
-          _handle_order_cancel_message(_read_tail<order_cancel_message>(buffer));
-          return true;
-        case message_type::ORDER_DELETE_MESSAGE:
-          _handle_order_delete_message(_read_tail<order_delete_message>(buffer)));
-          return true;
-        case message_type::ORDER_EXECUTED_MESSAGE:
-          _handle_order_executed_message(_read_tail<order_executed_message>(buffer));
-          return true;
-        case message_type::ORDER_EXECUTED_WITH_PRICE:
-          _handle_order_executed_with_price_message(_read_tail<order_executed_with_price_message>(buffer));
-          return true;
-        case message_type::ORDER_REPLACE_MESSAGE:
-          _handle_order_replace_message(_read_tail<order_replace_message>(buffer));
-          return true;
-        case message_type::ADD_ORDER_NO_MPID_MESSAGE:
-          _handle_add_order_no_mpid_message(_read_tail<add_order_no_mpid_message>(buffer));
-          return true;
-        case message_type::ADD_ORDER_WITH_MPID_MESSAGE:
-          _handle_add_order_with_mpid_message(_read_tail<add_order_with_mpid_message>(buffer));
-          return true;
-        case message_type::BROKEN_TRADE_MESSAGE:
-          _read_tail<broken_trade_message>(buffer);
-          return false;
-        case message_type::CROSS_TRADE_MESSAGE:
-          _read_tail<cross_trade_message>(buffer);
-          return false;
-        case message_type::IPO_QUOTING_PERIOD_MESSAGE:
-          _read_tail<ipo_quoting_period_update_message>(buffer);
-          return false;
-        case message_type::MARKET_PARTICIPANT_POSITION_MESSAGE:
-          _read_tail<market_participant_position_message>(buffer);
-          return false;
-        case message_type::MWCB_DECLINE_LEVEL_MESSAGE:
-          _read_tail<mwcb_decline_level_message>(buffer);
-          return false;
-        case message_type::MWCB_STATUS_MESSAGE:
-          _read_tail<mwcb_status_message>(buffer);
-          return false;
-        case message_type::LULD_AUCTION_COLLAR_MESSAGE:
-          _read_tail<luld_auction_collar_message>(buffer);
-          return false;
-        case message_type::NET_ORDER_IMBALANCE_INDICATOR_MESSAGE:
-          _read_tail<net_order_imbalance_indicator_message>(buffer);
-          return false;
-        case message_type::OPERATIONAL_HALT_MESSAGE:
-          _read_tail<operational_halt_message>(buffer);
-          return false;
-        case message_type::REG_SHO_INDICATOR_MESSAGE:
-          _read_tail<reg_sho_indicator_message>(buffer);
-          return false;
-        case message_type::STOCK_DIRECTORY_MESSAGE:
-          _read_tail<stock_directory_message>(buffer);
-          return false;
-        case message_type::STOCK_TRADING_ACTION_MESSAGE:
-          _read_tail<stock_trading_action_message>(buffer);
-          return false;
-        case message_type::SYSTEM_EVENT_MESSAGE:
-          _read_tail<system_event_message>(buffer);
-          return false;
-        case message_type::TRADE_MESSAGE:
-          _read_tail<trade_message>(buffer);
-          return false;
-        default:
-          /* Change to a log message once the logger is finished */
-          utility::zassert_ndebug(false, "Unrecognised message type.");
+      /* The message stays where the receiver put it. We overlay the packed structures on top of it. */
+      std::span<std::byte const> buffer = _receiver->next();
+      if (__unlikely(buffer.size() < sizeof(message_header)))
+      {
+        return false;
+      }
+
+      return _dispatch(buffer);
+    }
+
+    /**
+     * Handle up to a number of messages, or as many as the receiver has ready, and collect the books that changed. Use
+     * it to react once per burst rather than once per message.
+     *
+     * @param max_messages The most messages to handle
+     * @returns Each locate whose top of book changed, once, in the order they first changed. The view is valid until
+     *   the next call.
+     */
+    std::span<uint16_t const> poll_n(std::size_t max_messages)
+    {
+      _begin_batch();
+      for (std::size_t handled = 0; handled < max_messages; ++handled)
+      {
+        std::span<std::byte const> buffer = _receiver->next();
+        if (__unlikely(buffer.size() < sizeof(message_header)))
+        {
+          break;
+        }
+
+        if (_dispatch(buffer))
+        {
+          _mark_changed(reinterpret_cast<message_header const*>(buffer.data())->_stock_locate);
+        }
+      }
+
+      return _changed;
+    }
+
+    /**
+     * Handle every message the receiver has ready
+     *
+     * @returns Each locate whose top of book changed, as for poll_n
+     */
+    std::span<uint16_t const> drain()
+    {
+      return poll_n(std::numeric_limits<std::size_t>::max());
+    }
+
+    /**
+     * Get the book for a locate
+     *
+     * @param locate The stock locate code
+     * @returns The book, or nullptr if the locate has not been activated
+     */
+    [[nodiscard]] md::book const *book(uint16_t locate) const noexcept
+    {
+      uint32_t const index = _book_index[locate];
+      return index == _inactive ? nullptr : &_arena(index);
+    }
+
+    /** The number of locates that have an active book */
+    [[nodiscard]] std::size_t active_books() const noexcept { return _book_count; }
+
+    /** The number of order updates dropped because their locate never had an order added, nor a directory entry */
+    [[nodiscard]] std::size_t unknown_messages() const noexcept { return _unknown_messages; }
+
+    /***/
+    [[nodiscard]] Listener &listener() noexcept { return _listener; }
+
+    /**
+     * Get the trading state of a locate, kept up to date from the administrative messages. The state of a locate we are
+     * not subscribed to is not maintained.
+     *
+     * @param locate The stock locate code
+     */
+    [[nodiscard]] trading_state state(uint16_t locate) const noexcept { return _states[locate]; }
+
+    /** The symbols the stock directory has announced so far */
+    [[nodiscard]] symbol_directory const &directory() const noexcept { return _directory; }
+
+    /**
+     * Only maintain books and raise events for the symbols that have been subscribed to. Everything else is dropped as
+     * soon as we have read its header. Subscribe before the stock directory is sent, or at any point after it.
+     *
+     * A book that is subscribed to part way through the session only holds the orders added since. Its top of book is
+     * not to be trusted until the orders from before have left, or until it is restored from a snapshot. Updates to the
+     * orders it missed are ignored, and counted in book::unknown_orders(), or in unknown_messages() if the book has not
+     * been built yet.
+     *
+     * @param name The ticker, without padding
+     */
+    void subscribe(std::string_view name)
+    {
+      /* The first subscription switches from wanting everything to wanting only what is subscribed. Messages about the
+       * market as a whole are sent on locate 0, and are always wanted. */
+      if (_subscriptions.empty())
+      {
+        _wanted.reset();
+        _wanted.set(_market_wide);
+      }
+
+      _subscriptions.emplace(name);
+      if (uint16_t const locate = _directory.locate(name); locate != symbol_directory::npos)
+      {
+        _wanted.set(locate);
+      }
+    }
+
+    /** Whether messages for a locate are being handled */
+    [[nodiscard]] bool subscribed(uint16_t locate) const noexcept { return _wanted.test(locate); }
+
+    /**
+     * Save the state of the feed, so that a restart can carry on from here rather than replaying the day. This covers
+     * every book with its levels, queues and orders, the symbol directory, the trading states and the subscriptions. The
+     * receiver and the listener are not saved.
+     *
+     * @param path The file to write
+     * @param position Where the stream should be resumed from, e.g. the next MoldUDP64 sequence number. It is handed
+     *   back by restore().
+     */
+    void save(std::filesystem::path const &path, uint64_t position) const
+    {
+      md::snapshot_writer writer;
+      uint64_t const header_offset = writer.write(snapshot_header{});
+
+      /* Keep the books in arena order, so they are restored into the same order */
+      std::vector<saved_book> books(_book_count);
+      std::vector<saved_symbol> symbols;
+      for (std::size_t locate = 0; locate < _num_books; ++locate)
+      {
+        if (uint32_t const index = _book_index[locate]; index != _inactive)
+        {
+          books[index - 1] = saved_book{._offset = _arena(index).save(writer), ._locate = locate};
+        }
+
+        if (symbol const &entry = _directory[static_cast<uint16_t>(locate)]; entry.known())
+        {
+          symbols.push_back(saved_symbol{._locate = locate, ._symbol = entry, ._padding = 0});
+        }
+      }
+
+      /* Tickers are at most as long as they are on the wire */
+      std::vector<decltype(symbol::_stock)> subscriptions;
+      for (std::string const &name : _subscriptions)
+      {
+        decltype(symbol::_stock) &ticker = subscriptions.emplace_back();
+        ticker.fill(' ');
+        std::copy_n(name.begin(), std::min(name.size(), ticker.size()), ticker.begin());
+      }
+
+      writer.patch(header_offset, snapshot_header{
+        ._magic = _snapshot_magic,
+        ._version = _snapshot_version,
+        ._locates = _num_books,
+        ._position = position,
+        ._books = writer.write(std::span<saved_book const>{books}),
+        ._states = writer.write(std::span<trading_state const>{_states}),
+        ._symbols = writer.write(std::span<saved_symbol const>{symbols}),
+        ._subscriptions = writer.write(std::span<decltype(symbol::_stock) const>{subscriptions})
+      });
+      writer.save(path);
+    }
+
+    /**
+     * Replace the state of the feed with one saved by save(). The file is mapped once and each book is copied out of it
+     * wholesale, with nothing replayed. Any book handed out before is no longer valid. If the snapshot is rejected part
+     * way through, the feed must be restored again before it is used.
+     *
+     * @param path The file to read
+     * @returns The position that was saved with the state
+     */
+    uint64_t restore(std::filesystem::path const &path)
+    {
+      md::snapshot_reader reader{path};
+      if (reader.bytes().size() < sizeof(snapshot_header))
+      {
+        zeus::system::throw_runtime_error("feed", __func__, "Snapshot is too short: " + path.string());
+      }
+
+      snapshot_header const &header = reader.read<snapshot_header>(0);
+      if (header._magic != _snapshot_magic || header._version != _snapshot_version || header._locates != _num_books)
+      {
+        zeus::system::throw_runtime_error("feed", __func__, "Not a snapshot of this version: " + path.string());
+      }
+
+      std::span<saved_book const> const books = reader.read<saved_book>(header._books);
+      std::span<trading_state const> const states = reader.read<trading_state>(header._states);
+      if (books.size() > _num_books || states.size() != _num_books)
+      {
+        zeus::system::throw_runtime_error("feed", __func__, "Snapshot is inconsistent: " + path.string());
+      }
+
+      /* Every locate indexes straight into our tables, so check them all before anything is touched */
+      std::span<saved_symbol const> const symbols = reader.read<saved_symbol>(header._symbols);
+      std::bitset<_num_books> restored;
+      for (saved_book const &saved : books)
+      {
+        if (saved._locate >= _num_books || restored.test(saved._locate))
+        {
+          zeus::system::throw_runtime_error("feed", __func__, "Snapshot has a bad book locate of " +
+                                                              std::to_string(saved._locate) + ": " + path.string());
+        }
+        restored.set(saved._locate);
+      }
+
+      for (saved_symbol const &saved : symbols)
+      {
+        if (saved._locate >= _num_books)
+        {
+          zeus::system::throw_runtime_error("feed", __func__, "Snapshot has a bad symbol locate of " +
+                                                              std::to_string(saved._locate) + ": " + path.string());
+        }
+      }
+
+      _books.clear();
+      _book_count = 0;
+      _book_index.fill(_inactive);
+      for (saved_book const &saved : books)
+      {
+        _emplace(static_cast<uint16_t>(saved._locate), reader, saved._offset);
+      }
+
+      std::copy(states.begin(), states.end(), _states.begin());
+
+      _directory = symbol_directory{};
+      for (saved_symbol const &saved : symbols)
+      {
+        _directory.add(static_cast<uint16_t>(saved._locate), saved._symbol);
+      }
+
+      /* Subscribing again works out which locates are wanted from the directory we just restored */
+      _subscriptions.clear();
+      _wanted.set();
+      for (auto const &ticker : reader.read<decltype(symbol::_stock)>(header._subscriptions))
+      {
+        symbol subscribed{};
+        subscribed._stock = ticker;
+        subscribe(subscribed.name());
       }
+
+      _changed.clear();
+      _changed_in_batch.fill(0);
+      _batch = 0;
+      return header._position;
     }
 
   private:
+    /** Hand a message to its handler through the dispatch table */
+    bool _dispatch(std::span<std::byte const> buffer)
+    {
+      auto const type = static_cast<uint8_t>(buffer[0]);
+
+      /* A message shorter than its type is malformed. Skip it rather than read past the end. */
+      if (__unlikely(buffer.size() < _message_sizes[type]))
+      {
+        return false;
+      }
+
+      /* The directory is always read, as that is how we learn which locates are wanted. So is anything that is about the
+       * market as a whole rather than a single instrument. */
+      auto const &header = *reinterpret_cast<message_header const*>(buffer.data());
+      uint16_t const locate = header._stock_locate;
+      if (!_wanted.test(locate) && !_unfiltered[type])
+      {
+        return false;
+      }
+
+      /* Start pulling in the book's entry for the order now, so that fetching it overlaps with the dispatch rather than
+       * stalling the handler's lookup */
+      if (_updates_order[type])
+      {
+        if (md::book const *book = _find(locate); book != nullptr)
+        {
+          book->prefetch(reinterpret_cast<order_delete_message const *>(buffer.data())->_order_reference_number);
+        }
+      }
+
+      if (!_dispatch_table[type](*this, buffer))
+      {
+        return false;
+      }
+
+      /* The handler has built the book if it had to. Publish the new top of book for readers on other threads. */
+      md::book &updated = _arena(_book_index[locate]);
+      updated.publish(header._timestamp);
+
+      if constexpr (listens_to_books<Listener>)
+      {
+        _listener.on_book_update(locate, updated);
+      }
+      return true;
+    }
+
+    /** Start collecting the books changed by a new batch */
+    void _begin_batch()
+    {
+      _changed.clear();
+
+      /* Each locate remembers the last batch it changed in. Should the batch counter ever wrap, start afresh. */
+      if (__unlikely(++_batch == 0))
+      {
+        _changed_in_batch.fill(0);
+        _batch = 1;
+      }
+    }
+
+    /** Note that a book changed in this batch, unless we already have */
+    void _mark_changed(uint16_t locate)
+    {
+      if (_changed_in_batch[locate] != _batch)
+      {
+        _changed_in_batch[locate] = _batch;
+        _changed.push_back(locate);
+      }
+    }
+
+    /** Fetch the book for a locate, building it on first use. Only messages that can start a book come through here. */
+    md::book &_book(uint16_t locate)
+    {
+      uint32_t const index = _book_index[locate];
+      if (__likely(index != _inactive))
+      {
+        return _arena(index);
+      }
+
+      return _activate(locate);
+    }
+
+    /** Fetch the book for a locate, or nullptr if it has never been built */
+    md::book *_find(uint16_t locate) noexcept
+    {
+      uint32_t const index = _book_index[locate];
+      return __likely(index != _inactive) ? &_arena(index) : nullptr;
+    }
+
+    /** The book at a position in the arena, counting from one as the index does */
+    md::book &_arena(uint32_t index) noexcept
+    {
+      return _books[(index - 1) / _chunk_books][(index - 1) % _chunk_books];
+    }
+
+    /***/
+    md::book const &_arena(uint32_t index) const noexcept
+    {
+      return _books[(index - 1) / _chunk_books][(index - 1) % _chunk_books];
+    }
+
+    /** Build a book at the back of the arena. Books are laid out in activation order, so the active set stays compact. */
+    [[using gnu: cold, noinline]] md::book &_activate(uint16_t locate)
+    {
+      /* Assume here that we are only dealing with stocks listed > 1USD */
+      return _emplace(locate, core::price_t::from_underlying(math::pow(10, 6)), _order_capacity);
+    }
+
+    /** Construct a book at the back of the arena, starting a new chunk if the last one is full, and index it */
+    template<typename... Args>
+    md::book &_emplace(uint16_t locate, Args &&... args)
+    {
+      /* A chunk is never allowed to reallocate, so books stay where they are for the session */
+      if (_book_count % _chunk_books == 0)
+      {
+        _books.emplace_back().reserve(_chunk_books);
+      }
+
+      md::book &book = _books.back().emplace_back(std::forward<Args>(args)...);
+      _book_index[locate] = static_cast<uint32_t>(++_book_count);
+      return book;
+    }
+
+    /** An order update for a locate that has no book can only be about orders we never saw */
+    [[using gnu: cold, noinline]] bool _unknown_locate() noexcept
+    {
+      ++_unknown_messages;
+      return false;
+    }
+
+    /**
+     * The stock directory is sent for each locate at the start of day. Record the symbol, and build the book up front if
+     * we want it.
+     */
+    bool _handle(stock_directory_message const& message)
+    {
+      uint16_t const locate = message._header._stock_locate;
+      symbol const &entry = _directory.add(message);
+      if (!_subscriptions.empty())
+      {
+        _wanted.set(locate, _subscriptions.contains(entry.name()));
+      }
+
+      if (_wanted.test(locate))
+      {
+        _book(locate);
+      }
+      return false;
+    }
 
     /***/
-    [[nodiscard]] void _handle_add_order_with_mpid_message(add_order_with_mpid_message const& message)
+    bool _handle(add_order_with_mpid_message const& message)
     {
-      _handle_add_order_no_mpid_message(message._add_order);
+      return _handle(message._add_order);
     }
 
     /***/
-    [[nodiscard]] void _handle_add_order_no_mpid_message(add_order_no_mpid_message const& message)
+    bool _handle(add_order_no_mpid_message const& message)
     {
-      md::book& book = _books[message._header._stock_locate];
+      md::book& book = _book(message._header._stock_locate);
       md::order_add order_add{
         ._order_id = message._order_reference_number,
         ._quantity = message._shares,
-        ._price = core::price_t::from_underlying(message._price),
+        ._price = _to_price(message._price),
         ._side = message._buy_sell_indicator == 'B' ? core::order_side::BUY : core::order_side::SELL
       };
 
-      book.add(order_add);
+      return book.add(order_add);
     }
 
     /***/
-    [[nodiscard]] void _handle_order_cancel_message(order_cancel_message const& message)
+    bool _handle(order_cancel_message const& message)
     {
-      md::book& book =_books[message._header._stock_locate];
+      md::book *book = _find(message._header._stock_locate);
+      if (__unlikely(book == nullptr))
+      {
+        return _unknown_locate();
+      }
+
       md::order_canceled order_cancel{
         ._order_id = message._order_reference_number,
         ._shares_cancelled = message._cancelled_shares
       };
 
-      book.cancel(order_cancel);
+      return book->cancel(order_cancel);
     }
 
     /***/
-    [[nodiscard]] void _handle_order_delete_message(order_delete_message const& message)
+    bool _handle(order_delete_message const& message)
     {
-      md::book& book =_books[message._header._stock_locate];
+      md::book *book = _find(message._header._stock_locate);
+      if (__unlikely(book == nullptr))
+      {
+        return _unknown_locate();
+      }
+
       md::order_removed order_remove{
         ._order_id = message._order_reference_number
       };
 
-      book.remove(order_remove);
+      return book->remove(order_remove);
     }
 
     /***/
-    [[nodiscard]] void _handle_order_executed_message(order_executed_message const& message)
+    bool _handle(order_executed_message const& message)
     {
-      md::book& book =_books[message._header._stock_locate];
+      md::book *book = _find(message._header._stock_locate);
+      if (__unlikely(book == nullptr))
+      {
+        return _unknown_locate();
+      }
+
       md::order_executed order_execute{
         ._order_id = message._order_reference_number,
         ._shares_executed = message._executed_shares
       };
 
-      book.execute(order_execute);
+      return book->execute(order_execute);
     }
 
     /***/
-    [[nodiscard]] void _handle_order_executed_with_price_message(order_executed_with_price_message const& message)
+    bool _handle(order_executed_with_price_message const& message)
     {
-      md::book& book =_books[message._order_executed_message._header._stock_locate];
+      md::book *book = _find(message._order_executed_message._header._stock_locate);
+      if (__unlikely(book == nullptr))
+      {
+        return _unknown_locate();
+      }
+
       md::order_executed order_execute{
         ._order_id = message._order_executed_message._order_reference_number,
         ._shares_executed = message._order_executed_message._executed_shares
       };
       md::order_executed_with_price order_execute_with_price{
         ._order_executed = order_execute,
-        ._price = core::price_t::from_underlying(message._price)
+        ._price = _to_price(message._price)
       };
 
-      book.execute_with_price(order_execute_with_price);
-    };
+      return book->execute_with_price(order_execute_with_price);
+    }
 
     /***/
-    [[nodiscard]] void _handle_order_replace_message(order_replace_message const& message)
+    bool _handle(order_replace_message const& message)
     {
-      md::book& book =_books[message._header._stock_locate];
+      md::book *book = _find(message._header._stock_locate);
+      if (__unlikely(book == nullptr))
+      {
+        return _unknown_locate();
+      }
+
       md::order_replaced order_replace{
         ._original_order_id = message._original_order_reference_number,
         ._new_order_id = message._new_order_reference_number,
-        ._price = core::price_t::from_underlying(message._price),
-        ._quantity = message._shares
+        ._quantity = message._shares,
+        ._price = _to_price(message._price)
       };
 
-      book.replace(order_replace);
+      return book->replace(order_replace);
+    }
+
+    /***/
+    bool _handle(stock_trading_action_message const& message)
+    {
+      trading_state &state = _states[message._header._stock_locate];
+      state._status = static_cast<trading_status>(message._trading_state);
+      if (state._status == trading_status::TRADING)
+      {
+        state._auction_collar = false;
+      }
+      return false;
+    }
+
+    /***/
+    bool _handle(operational_halt_message const& message)
+    {
+      trading_state &state = _states[message._header._stock_locate];
+      uint8_t const bit = trading_state::halt_bit(message._market_code);
+      state._operational_halts = message._operational_halt_action == 'H' ? state._operational_halts | bit
+                                                                          : state._operational_halts & ~bit;
+      return false;
+    }
+
+    /***/
+    bool _handle(reg_sho_indicator_message const& message)
+    {
+      _states[message._header._stock_locate]._reg_sho = static_cast<reg_sho_status>(message._reg_sho_action);
+      return false;
+    }
+
+    /** A collar is only published while a LULD pause is extended */
+    bool _handle(luld_auction_collar_message const& message)
+    {
+      _states[message._header._stock_locate]._auction_collar = true;
+      return false;
+    }
+
+    /** ITCH prices carry 4 decimal places, whereas the book works with 8 */
+    static core::price_t _to_price(math::fixed<4, int32_t>::underlying_t price) noexcept
+    {
+      return core::price_t::from_underlying(static_cast<core::price_t::underlying_t>(price) * math::pow(10, 4));
+    }
+
+    /* The start of a snapshot. Everything else is found through the sections it points to. */
+    struct snapshot_header
+    {
+      std::array<char, 8> _magic;
+      uint32_t _version;
+      uint32_t _locates;
+      uint64_t _position;
+      md::snapshot_section _books;
+      md::snapshot_section _states;
+      md::snapshot_section _symbols;
+      md::snapshot_section _subscriptions;
     };
 
     /***/
+    struct saved_book
+    {
+      uint64_t _offset;
+      uint64_t _locate;
+    };
+
+    /***/
+    struct saved_symbol
+    {
+      uint64_t _locate;
+      symbol _symbol;
+
+      /** \brief Spelled out, as the snapshot writer will not copy padding */
+      uint32_t _padding;
+    };
+
+    /* Every entry of the dispatch table has the same signature, whatever the message */
+    using handler_t = bool (*)(feed &, std::span<std::byte const>);
+
+    /**
+     * Decode a message, pass it to the listener if it has a hook for it, then to the book. Messages that neither wants
+     * are ignored without decoding.
+     */
+    template<typename T>
+    static bool _invoke(feed &self, std::span<std::byte const> buffer)
+    {
+      constexpr bool handled = requires { self._handle(std::declval<T const &>()); };
+      constexpr bool listened = listens_to<Listener, T>;
+
+      if constexpr (handled || listened)
+      {
+        T const &message = _overlay<T>(buffer);
+        if constexpr (listened)
+        {
+          notify(self._listener, message);
+        }
+        if constexpr (handled)
+        {
+          return self._handle(message);
+        }
+      }
+      return false;
+    }
+
+    /** Unknown message types are skipped. The receiver has already framed them, so we know where the next one starts. */
+    static bool _skip(feed &, std::span<std::byte const>)
+    {
+      return false;
+    }
+
+    /** Build a table with an entry per value of the type byte */
+    template<typename... Messages>
+    static consteval std::array<handler_t, 256> _make_dispatch_table(type_list<Messages...>)
+    {
+      std::array<handler_t, 256> table{};
+      table.fill(&_skip);
+      ((table[static_cast<uint8_t>(Messages::type)] = &_invoke<Messages>), ...);
+      return table;
+    }
+
+    /** Mark a set of message types */
+    template<typename... Messages>
+    static consteval std::array<bool, 256> _make_type_set(type_list<Messages...>)
+    {
+      std::array<bool, 256> types{};
+      ((types[static_cast<uint8_t>(Messages::type)] = true), ...);
+      return types;
+    }
+
+    /***/
+    template<typename... Messages>
+    static consteval std::array<uint8_t, 256> _make_message_sizes(type_list<Messages...>)
+    {
+      static_assert(((sizeof(Messages) <= std::numeric_limits<uint8_t>::max()) && ...));
+
+      std::array<uint8_t, 256> sizes{};
+      ((sizes[static_cast<uint8_t>(Messages::type)] = sizeof(Messages)), ...);
+      return sizes;
+    }
+
+    /** The structures are packed, so we can read the message in place without copying it */
     template<typename T>
-    T const& _read_tail(std::byte* buffer)
+    static T const& _overlay(std::span<std::byte const> buffer)
     {
-      _receiver.read(buffer + sizeof(message_header), sizeof(T) - sizeof(message_header));
-      return *reinterpret_cast<T const*>(buffer);
+      utility::zassert(buffer.size() >= sizeof(T), "Message is shorter than its type.");
+      return *reinterpret_cast<T const*>(buffer.data());
     }
 
   private:
+    /* Generated from the list of message types, so adding a message is a matter of adding it to the list */
+    static constexpr std::array<handler_t, 256> _dispatch_table{_make_dispatch_table(message_types{})};
+    static constexpr std::array<uint8_t, 256> _message_sizes{_make_message_sizes(message_types{})};
+
+    /* The message types that get past the subscription filter, whatever their locate */
+    static constexpr std::array<bool, 256> _unfiltered{
+      _make_type_set(type_list<stock_directory_message, system_event_message, mwcb_decline_level_message,
+                               mwcb_status_message>{})};
+
+    /* The message types that update an existing order, all of which lead with its reference number */
+    static constexpr std::array<bool, 256> _updates_order{
+      _make_type_set(type_list<order_executed_message, order_executed_with_price_message, order_cancel_message,
+                               order_delete_message, order_replace_message>{})};
+
+    static_assert(offsetof(order_executed_message, _order_reference_number) == sizeof(message_header) &&
+                  offsetof(order_cancel_message, _order_reference_number) == sizeof(message_header) &&
+                  offsetof(order_delete_message, _order_reference_number) == sizeof(message_header) &&
+                  offsetof(order_replace_message, _original_order_reference_number) == sizeof(message_header));
+
+    /* The locate that messages about the whole market are sent on */
+    static constexpr uint16_t _market_wide{0};
+
+    /* Identifies a snapshot, and the layout it was written with. Bump the version whenever anything saved changes. */
+    static constexpr std::array<char, 8> _snapshot_magic{'Z', 'E', 'U', 'S', 'I', 'T', 'C', 'H'};
+    static constexpr uint32_t _snapshot_version{3};
+
     /* Explicitly use decltype to make the context of the value obvious */
-    static constexpr size_t _num_books = std::numeric_limits<decltype(message_header::_stock_locate)>::max() + 1;
-    std::array<md::book, _num_books> _books;
+    static constexpr size_t _num_books = std::numeric_limits<decltype(message_header::_stock_locate)::value_type>::max() + 1;
+
+    /* A locate whose book has not been built yet */
+    static constexpr uint32_t _inactive{0};
+
+    /** \brief For each locate, one past the position of its book in the arena, or _inactive */
+    std::array<uint32_t, _num_books> _book_index{};
+
+    /* The arena grows by this many books at a time */
+    static constexpr std::size_t _chunk_books{64};
+
+    /** \brief The arena of active books, in activation order. Each chunk is reserved up front and never reallocates. */
+    std::vector<std::vector<md::book>> _books{};
+
+    /** \brief The number of books in the arena */
+    std::size_t _book_count{0};
+
+    /** \brief The number of order updates dropped because their locate had no book */
+    std::size_t _unknown_messages{0};
+
+    /** \brief For each locate, the last batch in which its top of book changed */
+    std::array<uint32_t, _num_books> _changed_in_batch{};
+
+    /** \brief The current batch, numbered from 1 */
+    uint32_t _batch{0};
+
+    /** \brief The locates changed in the current batch */
+    std::vector<uint16_t> _changed{};
+
+    /** \brief For each locate, whether it can be traded */
+    std::array<trading_state, _num_books> _states{};
+
+    /** \brief Locate to symbol, from the stock directory */
+    symbol_directory _directory{};
+
+    /** \brief The tickers subscribed to */
+    std::set<std::string, std::less<>> _subscriptions{};
+
+    /** \brief For each locate, whether we handle its messages. Checked for every message, so kept dense. */
+    std::bitset<_num_books> _wanted{};
+
+    /** \brief The number of orders to preallocate storage for in each book */
+    std::size_t _order_capacity;
 
     /* This is where we will read our data stream from */
     std::unique_ptr<Receiver> _receiver;
+
+    /* Told about everything it has a hook for */
+    [[no_unique_address]] Listener _listener;
   };
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <span>
+
+#include "md/itch/receiver.h"
+#include "md/itch/types.h"
+#include "system/utilities.h"
+
+namespace zeus::md::itch
+{
+  /**
+   * Replays a NASDAQ TotalView-ITCH BinaryFILE from disk.
+   *
+   * The file is mapped read-only and messages are handed out in place, so replay runs as fast as the page cache can
+   * supply them. Replay can be cut short after a number of messages, or once the feed passes a timestamp.
+   */
+  class file_receiver
+  {
+  public:
+    /* Used when replay should run to the end of the file */
+    static constexpr std::size_t all_messages{std::numeric_limits<std::size_t>::max()};
+    static constexpr uint64_t end_of_day{std::numeric_limits<uint64_t>::max()};
+
+    /**
+     * @param path The BinaryFILE to replay
+     * @param max_messages Stop after this many messages have been delivered
+     * @param until Stop before the first message stamped later than this, in nanoseconds since midnight
+     */
+    explicit file_receiver(std::filesystem::path const &path, std::size_t max_messages = all_messages,
+                           uint64_t until = end_of_day);
+    ~file_receiver();
+
+    file_receiver(file_receiver const &) = delete;
+    file_receiver &operator=(file_receiver const &) = delete;
+
+    /***/
+    std::span<std::byte const> next() noexcept
+    {
+      if (__unlikely(_delivered == _max_messages))
+      {
+        return {};
+      }
+
+      std::span<std::byte const> message = _messages.next();
+      if (__unlikely(message.size() < sizeof(message_header)))
+      {
+        return {};
+      }
+
+      /* Only the timestamp is decoded here, and only when a cut-off has been asked for */
+      if (_until != end_of_day &&
+          static_cast<uint64_t>(reinterpret_cast<message_header const *>(message.data())->_timestamp) > _until)
+      {
+        _max_messages = _delivered;
+        return {};
+      }
+
+      ++_delivered;
+      return message;
+    }
+
+    /** The number of messages handed out so far */
+    [[nodiscard]] std::size_t delivered() const noexcept { return _delivered; }
+
+    /** The size of the file in bytes */
+    [[nodiscard]] std::size_t size() const noexcept { return _size; }
+
+  private:
+    /** \brief The start of the mapping, or nullptr for an empty file */
+    void *_mapping{nullptr};
+
+    /** \brief The length of the mapping */
+    std::size_t _size{0};
+
+    /** \brief Walks the framing of the mapped file */
+    buffer_receiver _messages{{}};
+
+    /** \brief The number of messages to deliver before stopping */
+    std::size_t _max_messages;
+
+    /** \brief The latest timestamp to deliver */
+    uint64_t _until;
+
+    /** \brief The number of messages delivered */
+    std::size_t _delivered{0};
+  };
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <thread>
+
+#include "md/itch/receiver.h"
+#include "thread/spsc_circular_buffer.h"
+
+namespace zeus::md::itch
+{
+  /**
+   * Replays a gzipped BinaryFILE straight from the archive.
+   *
+   * A dedicated thread inflates the file directly into a ring buffer, and messages are handed out from the ring in
+   * place. The ring is mapped twice back to back, so a message that wraps around the end is still contiguous and never
+   * needs to be stitched together. Replay runs at the speed of decompression, with nothing staged on disk.
+   */
+  class gzip_receiver
+  {
+  private:
+    static constexpr std::size_t _ring_size{std::size_t{1} << 24};
+    static constexpr std::size_t _length_size{sizeof(uint16_t)};
+
+  public:
+    /**
+     * @param path The gzipped BinaryFILE to replay
+     */
+    explicit gzip_receiver(std::filesystem::path const &path);
+    ~gzip_receiver();
+
+    gzip_receiver(gzip_receiver const &) = delete;
+    gzip_receiver &operator=(gzip_receiver const &) = delete;
+
+    /***/
+    std::span<std::byte const> next() noexcept
+    {
+      /* The previous message is only released now, so the view we handed out stays valid until this call */
+      _ring.consume(_pending);
+      _pending = 0;
+
+      std::span<std::byte const> available = _ring.peek();
+      std::size_t const framed = _framed_size(available);
+      if (framed == 0)
+      {
+        return {};
+      }
+
+      _pending = framed;
+      return available.subspan(_length_size, framed - _length_size);
+    }
+
+    /** Whether the whole file has been inflated and every message read. A truncated message at the end is dropped. */
+    [[nodiscard]] bool finished() const noexcept
+    {
+      return _inflated.load(std::memory_order_acquire) && _framed_size(_ring.peek().subspan(_pending)) == 0;
+    }
+
+    /** Whether decompression stopped early because the archive is corrupt or truncated */
+    [[nodiscard]] bool failed() const noexcept { return _failed.load(std::memory_order_acquire); }
+
+  private:
+    /** The size of the message at the front of the data including its length prefix, or 0 if it is incomplete */
+    static std::size_t _framed_size(std::span<std::byte const> available) noexcept
+    {
+      if (available.size() < _length_size)
+      {
+        return 0;
+      }
+
+      auto const *prefix = reinterpret_cast<uint8_t const *>(available.data());
+      std::size_t const framed = _length_size + (static_cast<std::size_t>(prefix[0]) << 8 | prefix[1]);
+      return available.size() < framed ? 0 : framed;
+    }
+
+    /** Runs on the decompression thread */
+    void _inflate(void *file);
+
+  private:
+    /** \brief Decompressed BinaryFILE data, waiting to be read */
+    thread::spsc_circular_buffer<std::byte, _ring_size> _ring;
+
+    /** \brief The number of bytes of the ring taken up by the last message handed out */
+    std::size_t _pending{0};
+
+    /** \brief Set by the decompression thread once it has written the last byte */
+    std::atomic<bool> _inflated{false};
+
+    /** \brief Set by the decompression thread if the archive could not be read */
+    std::atomic<bool> _failed{false};
+
+    /** \brief Tells the decompression thread to give up, if the receiver is destroyed mid-replay */
+    std::atomic<bool> _stop{false};
+
+    /** \brief The decompression thread */
+    std::thread _thread;
+  };
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <span>
+
+#include "md/itch/mold_udp64.h"
+#include "md/itch/receiver.h"
+#include "system/utilities.h"
+
+namespace zeus::md::itch
+{
+  /**
+   * Merges the A and B lines of a redundant MoldUDP64 feed into a single stream of datagrams.
+   *
+   * Both lines are polled, and whichever delivers the next sequence number first wins. Anything the other line sends for
+   * sequence numbers we have already released is dropped. A line that runs ahead of the sequence, because it has lost a
+   * packet, is parked with its datagram still in place and is not read again until the other line fills the hole.
+   * Unread packets simply queue up in the socket, so nothing is copied while we wait.
+   *
+   * If both lines are ahead, or the other line stays silent for too long, the hole is given up on and the parked packet
+   * is released. The downstream mold_udp64_session then reports the gap and trims any overlap.
+   */
+  template<packet_source Line>
+  class line_arbitrator
+  {
+  private:
+    static constexpr std::size_t _default_patience{1024};
+
+  public:
+    /**
+     * @param a The A line
+     * @param b The B line
+     * @param first_sequence The sequence number of the first message we expect to see
+     * @param patience The number of polls to wait for one line to fill a hole in the other, before giving up on it
+     */
+    line_arbitrator(std::unique_ptr<Line> a, std::unique_ptr<Line> b, uint64_t first_sequence = 1,
+                    std::size_t patience = _default_patience)
+      : _lines{line{._source = std::move(a)}, line{._source = std::move(b)}}, _expected(first_sequence),
+        _patience(patience)
+    {
+    }
+
+    /***/
+    std::span<std::byte const> receive() noexcept
+    {
+      for (;;)
+      {
+        bool arrived = false;
+        for (line &current : _lines)
+        {
+          if (current._packet.empty())
+          {
+            current._packet = current._source->receive();
+            arrived |= !current._packet.empty();
+          }
+        }
+
+        /* Release the first packet that carries the next sequence number, and drop anything we have already seen */
+        for (line &current : _lines)
+        {
+          if (current._packet.empty())
+          {
+            continue;
+          }
+
+          auto const [sequence, count] = _range(current._packet);
+          if (sequence + count <= _expected && !(count == 0 && sequence == _expected))
+          {
+            ++_duplicates;
+            current._packet = {};
+            continue;
+          }
+
+          if (sequence <= _expected)
+          {
+            return _release(current, sequence + count);
+          }
+        }
+
+        /* Whatever is left is ahead of the sequence. If both lines are, the hole is on both and cannot be filled. */
+        line &a = _lines[0];
+        line &b = _lines[1];
+        if (!a._packet.empty() && !b._packet.empty())
+        {
+          line &lowest = _range(a._packet).first <= _range(b._packet).first ? a : b;
+          return _abandon(lowest);
+        }
+
+        if (arrived)
+        {
+          continue;
+        }
+
+        /* Nothing new on the other line this poll. Only wait so long for it. */
+        for (line &current : _lines)
+        {
+          if (!current._packet.empty() && ++current._waited >= _patience)
+          {
+            return _abandon(current);
+          }
+        }
+
+        return {};
+      }
+    }
+
+    /** The sequence number of the next message to be released */
+    [[nodiscard]] uint64_t expected_sequence() const noexcept { return _expected; }
+
+    /** The number of packets released from the A line */
+    [[nodiscard]] std::size_t released_from_a() const noexcept { return _lines[0]._released; }
+
+    /** The number of packets released from the B line */
+    [[nodiscard]] std::size_t released_from_b() const noexcept { return _lines[1]._released; }
+
+    /** The number of packets dropped because everything in them had already been released */
+    [[nodiscard]] std::size_t duplicates() const noexcept { return _duplicates; }
+
+    /** The number of holes that neither line could fill */
+    [[nodiscard]] std::size_t abandoned() const noexcept { return _abandoned; }
+
+  private:
+    struct line
+    {
+      /** \brief Where this line's datagrams come from */
+      std::unique_ptr<Line> _source;
+
+      /** \brief A datagram we have read but not yet released or dropped */
+      std::span<std::byte const> _packet{};
+
+      /** \brief The number of polls the parked datagram has waited for the other line */
+      std::size_t _waited{0};
+
+      /** \brief The number of datagrams released from this line */
+      std::size_t _released{0};
+    };
+
+    /** The first sequence number in a datagram and the number of messages it carries */
+    static std::pair<uint64_t, uint64_t> _range(std::span<std::byte const> packet) noexcept
+    {
+      /* A runt cannot be sequenced. Treat it as something we have already seen, so it is dropped. */
+      if (__unlikely(packet.size() < sizeof(mold_udp64_header)))
+      {
+        return {0, 0};
+      }
+
+      auto const &header = *reinterpret_cast<mold_udp64_header const *>(packet.data());
+      uint16_t const count = header._message_count;
+      return {header._sequence_number, count == mold_udp64_header::end_of_session ? 0 : count};
+    }
+
+    /***/
+    std::span<std::byte const> _release(line &winner, uint64_t end) noexcept
+    {
+      std::span<std::byte const> packet = winner._packet;
+      winner._packet = {};
+      winner._waited = 0;
+      ++winner._released;
+
+      /* A heartbeat does not move the sequence on */
+      _expected = std::max(_expected, end);
+      return packet;
+    }
+
+    /***/
+    [[using gnu: cold, noinline]] std::span<std::byte const> _abandon(line &ahead) noexcept
+    {
+      ++_abandoned;
+      auto const [sequence, count] = _range(ahead._packet);
+      return _release(ahead, sequence + count);
+    }
+
+  private:
+    /** \brief The A and B lines */
+    std::array<line, 2> _lines;
+
+    /** \brief The sequence number of the next message to be released. Everything before it has been released. */
+    uint64_t _expected;
+
+    /** \brief How long to wait for a hole to be filled */
+    std::size_t _patience;
+
+    /** \brief The number of datagrams dropped as duplicates */
+    std::size_t _duplicates{0};
+
+    /** \brief The number of holes given up on */
+    std::size_t _abandoned{0};
+  };
+}
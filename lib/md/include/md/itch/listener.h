@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+
+#include "md/book.h"
+#include "md/itch/types.h"
+
+namespace zeus::md::itch
+{
+  /**
+   * The feed hands events to a listener that it is given as a template parameter, so every hook is a direct call that
+   * can be inlined. A listener implements only the hooks it is interested in, e.g.
+   *
+   *   void on_book_update(uint16_t locate, md::book const &book);
+   *   void on_system_event(system_event_message const &message);
+   *   void on_mwcb_decline_level(mwcb_decline_level_message const &message);
+   *   void on_mwcb_status(mwcb_status_message const &message);
+   *   void on_execution(order_executed_message const &message);
+   *   void on_trade(trade_message const &message);
+   *   void on_cross(cross_trade_message const &message);
+   *   void on_broken_trade(broken_trade_message const &message);
+   *   void on_imbalance(net_order_imbalance_indicator_message const &message);
+   *   void on_trading_action(stock_trading_action_message const &message);
+   *   void on_operational_halt(operational_halt_message const &message);
+   *
+   * Hooks that are not implemented compile away entirely. A message that no hook and no book wants is never decoded.
+   * on_execution is called for both kinds of execution message, and before the book is updated. on_book_update is
+   * called after any message that changed the top of a book. Subscribing to symbols never filters out the system
+   * event and market wide circuit breaker messages, as they are not about any one symbol.
+   */
+  struct null_listener
+  {
+  };
+
+  /* Maps each message type onto its hook. These only exist for listeners that implement the hook. */
+  template<typename L>
+  auto notify(L &listener, system_event_message const &message) -> decltype(listener.on_system_event(message))
+  {
+    return listener.on_system_event(message);
+  }
+
+  template<typename L>
+  auto notify(L &listener, mwcb_decline_level_message const &message)
+    -> decltype(listener.on_mwcb_decline_level(message))
+  {
+    return listener.on_mwcb_decline_level(message);
+  }
+
+  template<typename L>
+  auto notify(L &listener, mwcb_status_message const &message) -> decltype(listener.on_mwcb_status(message))
+  {
+    return listener.on_mwcb_status(message);
+  }
+
+  template<typename L>
+  auto notify(L &listener, order_executed_message const &message) -> decltype(listener.on_execution(message))
+  {
+    return listener.on_execution(message);
+  }
+
+  template<typename L>
+  auto notify(L &listener, order_executed_with_price_message const &message)
+    -> decltype(listener.on_execution(message._order_executed_message))
+  {
+    return listener.on_execution(message._order_executed_message);
+  }
+
+  template<typename L>
+  auto notify(L &listener, trade_message const &message) -> decltype(listener.on_trade(message))
+  {
+    return listener.on_trade(message);
+  }
+
+  template<typename L>
+  auto notify(L &listener, cross_trade_message const &message) -> decltype(listener.on_cross(message))
+  {
+    return listener.on_cross(message);
+  }
+
+  template<typename L>
+  auto notify(L &listener, broken_trade_message const &message) -> decltype(listener.on_broken_trade(message))
+  {
+    return listener.on_broken_trade(message);
+  }
+
+  template<typename L>
+  auto notify(L &listener, net_order_imbalance_indicator_message const &message)
+    -> decltype(listener.on_imbalance(message))
+  {
+    return listener.on_imbalance(message);
+  }
+
+  template<typename L>
+  auto notify(L &listener, stock_trading_action_message const &message) -> decltype(listener.on_trading_action(message))
+  {
+    return listener.on_trading_action(message);
+  }
+
+  template<typename L>
+  auto notify(L &listener, operational_halt_message const &message) -> decltype(listener.on_operational_halt(message))
+  {
+    return listener.on_operational_halt(message);
+  }
+
+  /** Whether a listener has a hook for a message type */
+  template<typename L, typename T>
+  concept listens_to = requires(L &listener, T const &message) { notify(listener, message); };
+
+  /** Whether a listener wants to hear about changes to the top of book */
+  template<typename L>
+  concept listens_to_books = requires(L &listener, md::book const &book) { listener.on_book_update(uint16_t{}, book); };
+}
\ No newline at end of file
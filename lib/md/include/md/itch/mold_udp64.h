@@ -0,0 +1,237 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <span>
+
+#include "md/itch/receiver.h"
+#include "system/endian.h"
+#include "system/utilities.h"
+
+namespace zeus::md::itch
+{
+  struct mold_udp64_header
+  {
+    using session_t = char[10];
+
+    /* Message counts with a special meaning */
+    static constexpr uint16_t heartbeat{0};
+    static constexpr uint16_t end_of_session{0xFFFF};
+
+    session_t _session;
+    system::be_u64 _sequence_number;
+    system::be_u16 _message_count;
+  } __attribute__((packed));
+
+  static_assert(sizeof(mold_udp64_header) == 20);
+
+  /**
+   * Unpacks MoldUDP64 datagrams into a stream of ITCH messages, and tracks the sequence numbers to detect drops.
+   *
+   * Messages are handed out in place, straight from the datagram, one at a time. Packets that we have already seen are
+   * discarded, and any partial overlap with a retransmission is trimmed, so each sequence number is delivered at most
+   * once. When a packet arrives ahead of the sequence we expect, the missing range is reported to the gap handler and
+   * the session carries on from the new packet. A datagram that is cut short is read up to where it breaks off and
+   * counted, and whatever it was missing shows up as a gap in front of the next one.
+   */
+  template<packet_source Source>
+  class mold_udp64_session
+  {
+  private:
+    static constexpr std::size_t _length_size{sizeof(uint16_t)};
+
+  public:
+    /** A range of sequence numbers that never arrived, [_from, _to) */
+    struct gap
+    {
+      uint64_t _from;
+      uint64_t _to;
+    };
+
+    using gap_handler = std::function<void(gap const &)>;
+
+    /**
+     * @param source Where to read datagrams from
+     * @param on_gap Called with each range of messages that has been dropped, before the messages that follow the gap
+     *   are handed out. Anything it throws propagates out of next(), with the gap already accounted for and the datagram
+     *   that showed it up still ready to be read.
+     * @param first_sequence The sequence number of the first message we expect to see
+     */
+    explicit mold_udp64_session(std::unique_ptr<Source> source, gap_handler on_gap = {}, uint64_t first_sequence = 1)
+      : _source(std::move(source)), _on_gap(std::move(on_gap)), _expected(first_sequence)
+    {
+    }
+
+    /***/
+    std::span<std::byte const> next()
+    {
+      for (;;)
+      {
+        /* Only pull in another datagram once every message in this one has been handed out */
+        while (_remaining == 0)
+        {
+          std::span<std::byte const> packet = _source->receive();
+          if (packet.empty())
+          {
+            return {};
+          }
+
+          _open(packet);
+        }
+
+        std::span<std::byte const> message = _block();
+        if (__likely(!message.empty()))
+        {
+          --_remaining;
+          ++_expected;
+          return message;
+        }
+
+        /* An empty view means there is nothing left to read, so carry on with the next datagram instead */
+        _drop_truncated();
+      }
+    }
+
+    /** The sequence number of the next message we expect */
+    [[nodiscard]] uint64_t expected_sequence() const noexcept { return _expected; }
+
+    /** The number of gaps seen so far */
+    [[nodiscard]] std::size_t gaps() const noexcept { return _gaps; }
+
+    /** The number of messages lost to gaps so far */
+    [[nodiscard]] uint64_t missed() const noexcept { return _missed; }
+
+    /** The number of datagrams that were shorter than their header claimed */
+    [[nodiscard]] std::size_t truncated() const noexcept { return _truncated; }
+
+    /** Whether the upstream has announced the end of the session */
+    [[nodiscard]] bool ended() const noexcept { return _ended; }
+
+  private:
+    /** Check a datagram against the session and the sequence, and get ready to hand out its messages */
+    void _open(std::span<std::byte const> packet)
+    {
+      if (__unlikely(packet.size() < sizeof(mold_udp64_header)))
+      {
+        return;
+      }
+
+      auto const &header = *reinterpret_cast<mold_udp64_header const *>(packet.data());
+
+      /* Join the first session we hear from, and ignore any stale traffic from another */
+      if (__unlikely(!_joined))
+      {
+        std::memcpy(_session, header._session, sizeof(_session));
+        _joined = true;
+      }
+      else if (__unlikely(std::memcmp(_session, header._session, sizeof(_session)) != 0))
+      {
+        return;
+      }
+
+      uint16_t const count = header._message_count;
+      if (__unlikely(count == mold_udp64_header::end_of_session))
+      {
+        _ended = true;
+        return;
+      }
+
+      /* Heartbeats carry the next sequence number, so they show up a gap just like data does */
+      uint64_t const sequence = header._sequence_number;
+      uint64_t const gap_from = _expected;
+      if (__unlikely(sequence > _expected))
+      {
+        _record_gap(sequence);
+      }
+
+      _packet = packet.subspan(sizeof(mold_udp64_header));
+      _remaining = count;
+
+      /* Skip anything we have already delivered, from a duplicate or an overlapping retransmission */
+      uint64_t const seen = std::min<uint64_t>(_expected - std::min(sequence, _expected), count);
+      for (uint64_t skipped = 0; skipped < seen && !_block().empty(); ++skipped)
+      {
+        --_remaining;
+      }
+
+      /* Only hand the gap over once our own state is consistent, in case the handler throws */
+      if (__unlikely(sequence > gap_from) && _on_gap)
+      {
+        _on_gap(gap{._from = gap_from, ._to = sequence});
+      }
+    }
+
+    /** Take the next message block off the front of the datagram, or an empty view if it is truncated */
+    std::span<std::byte const> _block() noexcept
+    {
+      if (__unlikely(_packet.size() < _length_size))
+      {
+        return {};
+      }
+
+      auto const *prefix = reinterpret_cast<uint8_t const *>(_packet.data());
+      std::size_t const length = static_cast<std::size_t>(prefix[0]) << 8 | prefix[1];
+      if (__unlikely(_packet.size() < _length_size + length || length == 0))
+      {
+        return {};
+      }
+
+      std::span<std::byte const> message = _packet.subspan(_length_size, length);
+      _packet = _packet.subspan(_length_size + length);
+      return message;
+    }
+
+    /** The datagram is shorter than its header claims. Drop the rest of it, and the next one will show it up as a gap. */
+    [[using gnu: cold, noinline]] void _drop_truncated() noexcept
+    {
+      ++_truncated;
+      _remaining = 0;
+    }
+
+    /***/
+    [[using gnu: cold, noinline]] void _record_gap(uint64_t sequence) noexcept
+    {
+      ++_gaps;
+      _missed += sequence - _expected;
+      _expected = sequence;
+    }
+
+  private:
+    /** \brief Where datagrams come from */
+    std::unique_ptr<Source> _source;
+
+    /** \brief Told about every range of messages we miss */
+    gap_handler _on_gap;
+
+    /** \brief The sequence number of the next message we expect */
+    uint64_t _expected;
+
+    /** \brief The message blocks of the current datagram that have not been handed out yet */
+    std::span<std::byte const> _packet{};
+
+    /** \brief The number of messages left in the current datagram */
+    std::size_t _remaining{0};
+
+    /** \brief The session we have joined */
+    mold_udp64_header::session_t _session{};
+
+    /** \brief Whether we have joined a session yet */
+    bool _joined{false};
+
+    /** \brief Whether the upstream has ended the session */
+    bool _ended{false};
+
+    /** \brief The number of gaps seen */
+    std::size_t _gaps{0};
+
+    /** \brief The number of messages lost to gaps */
+    uint64_t _missed{0};
+
+    /** \brief The number of datagrams cut short */
+    std::size_t _truncated{0};
+  };
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "system/utilities.h"
+
+namespace zeus::md::itch
+{
+  /**
+   * A source of ITCH messages that hands out messages in place, without copying them.
+   *
+   * Each call to next() returns the next whole message as a view over memory the receiver already holds (a datagram, a
+   * mapped file, a ring buffer slot...) and moves the receiver past it. The view is only valid until the following call.
+   * An empty view means there is nothing to read right now.
+   */
+  template<typename R>
+  concept receiver = requires(R r) {
+    { r.next() } -> std::same_as<std::span<std::byte const>>;
+  };
+
+  /**
+   * A source of whole datagrams, such as a multicast socket. Each call to receive() returns the next datagram as a view
+   * that is only valid until the following call, or an empty view if nothing has arrived.
+   */
+  template<typename S>
+  concept packet_source = requires(S s) {
+    { s.receive() } -> std::same_as<std::span<std::byte const>>;
+  };
+
+  /**
+   * Reads messages out of a contiguous region of memory in the NASDAQ BinaryFILE framing, where each message is preceded
+   * by its length as a 2-byte big-endian integer. The region is not owned by the receiver.
+   */
+  class buffer_receiver
+  {
+  private:
+    static constexpr std::size_t _length_size{sizeof(uint16_t)};
+
+  public:
+    /***/
+    explicit buffer_receiver(std::span<std::byte const> buffer) noexcept : _buffer(buffer)
+    {
+    }
+
+    /***/
+    std::span<std::byte const> next() noexcept
+    {
+      if (__unlikely(_position + _length_size > _buffer.size()))
+      {
+        return {};
+      }
+
+      auto const *prefix = reinterpret_cast<uint8_t const *>(_buffer.data() + _position);
+      std::size_t const length = static_cast<std::size_t>(prefix[0]) << 8 | prefix[1];
+
+      /* A truncated message at the end of the buffer is treated as the end of the stream */
+      if (__unlikely(_position + _length_size + length > _buffer.size()))
+      {
+        return {};
+      }
+
+      std::span<std::byte const> message = _buffer.subspan(_position + _length_size, length);
+      _position += _length_size + length;
+      return message;
+    }
+
+    /** The number of bytes that have not been read yet */
+    [[nodiscard]] std::size_t remaining() const noexcept { return _buffer.size() - _position; }
+
+  private:
+    /** \brief The region we are reading from */
+    std::span<std::byte const> _buffer;
+
+    /** \brief The offset of the next length prefix */
+    std::size_t _position{0};
+  };
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "md/itch/types.h"
+
+namespace zeus::md::itch
+{
+  /** What the stock directory tells us about an instrument */
+  struct symbol
+  {
+    /** The ticker, without the padding it has on the wire */
+    [[nodiscard]] std::string_view name() const noexcept
+    {
+      std::string_view const padded{_stock.data(), _stock.size()};
+      std::size_t const end = padded.find_last_not_of(' ');
+      return end == std::string_view::npos ? std::string_view{} : padded.substr(0, end + 1);
+    }
+
+    /** Whether the directory has described this locate */
+    [[nodiscard]] bool known() const noexcept { return _stock[0] != '\0'; }
+
+    /** Whether the instrument is an exchange traded product */
+    [[nodiscard]] bool etp() const noexcept { return _etp_flag == 'Y'; }
+
+    std::array<char, sizeof(stock_t)> _stock{};
+    uint32_t _round_lot_size{0};
+    uint32_t _etp_leverage_factor{0};
+    uint8_t _market_category{0};
+    uint8_t _luld_reference_price_tier{0};
+    uint8_t _etp_flag{0};
+    uint8_t _inverse_indicator{0};
+  };
+
+  /**
+   * Maps locates onto symbols, as announced by the stock directory at the start of day. Lookups by locate are direct.
+   * Lookups by name are only meant for setting up, and go through an ordered map.
+   */
+  class symbol_directory
+  {
+  public:
+    static constexpr uint16_t npos{std::numeric_limits<uint16_t>::max()};
+
+    /***/
+    symbol_directory() : _symbols(std::numeric_limits<uint16_t>::max() + 1)
+    {
+    }
+
+    /**
+     * Record a directory entry
+     *
+     * @returns The symbol as recorded
+     */
+    symbol const &add(stock_directory_message const &message)
+    {
+      symbol entry{};
+      std::copy(std::begin(message._stock), std::end(message._stock), entry._stock.begin());
+      entry._round_lot_size = message._round_lot_size;
+      entry._etp_leverage_factor = message._etp_leverage_factor;
+      entry._market_category = message._market_category;
+      entry._luld_reference_price_tier = message._luld_reference_price_tier;
+      entry._etp_flag = message._etp_flag;
+      entry._inverse_indicator = message._inverse_indicator;
+      return add(message._header._stock_locate, entry);
+    }
+
+    /**
+     * Record a symbol against a locate, e.g. when restoring a snapshot
+     *
+     * @returns The symbol as recorded
+     */
+    symbol const &add(uint16_t locate, symbol const &entry)
+    {
+      _symbols[locate] = entry;
+      _locates.insert_or_assign(std::string{entry.name()}, locate);
+      return _symbols[locate];
+    }
+
+    /***/
+    [[nodiscard]] symbol const &operator[](uint16_t locate) const noexcept { return _symbols[locate]; }
+
+    /**
+     * Find the locate of a ticker
+     *
+     * @returns The locate, or npos if the directory has not mentioned it
+     */
+    [[nodiscard]] uint16_t locate(std::string_view name) const
+    {
+      auto it = _locates.find(name);
+      return it == _locates.end() ? npos : it->second;
+    }
+
+    /** The number of symbols in the directory */
+    [[nodiscard]] std::size_t size() const noexcept { return _locates.size(); }
+
+  private:
+    /** \brief Indexed by locate */
+    std::vector<symbol> _symbols;
+
+    /** \brief From ticker to locate */
+    std::map<std::string, uint16_t, std::less<>> _locates{};
+  };
+}
\ No newline at end of file
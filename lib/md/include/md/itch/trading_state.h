@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+namespace zeus::md::itch
+{
+  /** The trading state of an instrument on NASDAQ, from the stock trading action message */
+  enum class trading_status : uint8_t
+  {
+    UNKNOWN = 0,
+    HALTED = 'H',
+    PAUSED = 'P',
+    QUOTATION_ONLY = 'Q',
+    TRADING = 'T'
+  };
+
+  /** The Reg SHO short sale price test restriction, from the Reg SHO indicator message */
+  enum class reg_sho_status : uint8_t
+  {
+    NONE = '0',
+    INTRADAY = '1',
+    CONTINUED = '2'
+  };
+
+  /**
+   * Everything the administrative messages tell us about whether an instrument can be traded. It fits in a word, so a
+   * check on the hot path is a single load.
+   */
+  struct trading_state
+  {
+    /* One bit for each market that can declare an operational halt */
+    static constexpr uint8_t nasdaq_halt{1 << 0};
+    static constexpr uint8_t bx_halt{1 << 1};
+    static constexpr uint8_t psx_halt{1 << 2};
+
+    /** Whether orders can be executed right now */
+    [[nodiscard]] bool tradeable() const noexcept
+    {
+      return _status == trading_status::TRADING && _operational_halts == 0;
+    }
+
+    /** Whether the instrument is halted or paused */
+    [[nodiscard]] bool halted() const noexcept
+    {
+      return _status == trading_status::HALTED || _status == trading_status::PAUSED;
+    }
+
+    /** Whether a short sale price test restriction is in effect */
+    [[nodiscard]] bool short_sale_restricted() const noexcept { return _reg_sho != reg_sho_status::NONE; }
+
+    /** The bit for the market code of an operational halt, or zero if we do not know the market */
+    static constexpr uint8_t halt_bit(uint8_t market_code) noexcept
+    {
+      switch (market_code)
+      {
+        case 'Q': return nasdaq_halt;
+        case 'B': return bx_halt;
+        case 'X': return psx_halt;
+        default: return 0;
+      }
+    }
+
+    trading_status _status{trading_status::UNKNOWN};
+    reg_sho_status _reg_sho{reg_sho_status::NONE};
+
+    /** \brief Markets that currently have an operational halt in place */
+    uint8_t _operational_halts{0};
+
+    /** \brief Whether a LULD pause is being extended by an auction collar. Cleared when trading resumes. */
+    bool _auction_collar{false};
+  };
+
+  static_assert(sizeof(trading_state) == 4);
+}
\ No newline at end of file
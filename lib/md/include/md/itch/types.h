@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstdint>
+
+#include "math/fixed.h"
+#include "system/endian.h"
+
 namespace zeus::md::itch
 {
   using stock_t = char[8];
@@ -29,29 +34,39 @@ namespace zeus::md::itch
     NET_ORDER_IMBALANCE_INDICATOR_MESSAGE = 'I'
   };
 
+  /* ITCH integers are big-endian on the wire. Fields are swapped lazily when they are read. */
+  using be_u16 = system::be_u16;
+  using be_u32 = system::be_u32;
+  using be_u64 = system::be_u64;
+  using be_price4_t = system::big_endian<math::fixed<4, int32_t>::underlying_t>;
+  using be_price8_t = system::big_endian<math::fixed<8>::underlying_t>;
+
+  /** Nanoseconds since midnight, as a 6-byte big-endian integer */
   class timestamp
   {
   public:
-    operator uint64_t()
+    operator uint64_t() const noexcept
     {
-      return static_cast<uint64_t>(lower) << 32 | static_cast<uint64_t>(upper) << 48;
+      return static_cast<uint64_t>(upper) << 32 | static_cast<uint64_t>(lower);
     }
 
   public:
-    uint16_t upper;
-    uint32_t lower;
+    be_u16 upper;
+    be_u32 lower;
   } __attribute__((packed));
 
   struct message_header
   {
     message_type _type;
-    uint16_t _stock_locate;
-    uint16_t _tracking_number;
+    be_u16 _stock_locate;
+    be_u16 _tracking_number;
     timestamp _timestamp;
   } __attribute__((packed));
 
   struct system_event_message
   {
+    static constexpr message_type type{message_type::SYSTEM_EVENT_MESSAGE};
+
     enum struct event_code : uint8_t
     {
       START_OF_MESSAGES = 'O',
@@ -70,13 +85,15 @@ namespace zeus::md::itch
 
   struct stock_directory_message
   {
+    static constexpr message_type type{message_type::STOCK_DIRECTORY_MESSAGE};
+
     using issue_subtype_t = uint8_t[2];
 
     message_header _header;
     stock_t _stock;
     uint8_t _market_category;
     uint8_t _financial_status_indicator;
-    uint32_t _round_lot_size;
+    be_u32 _round_lot_size;
     uint8_t _round_lots_indicator;
     uint8_t _issue_structification;
     issue_subtype_t _issue_subtype;
@@ -85,7 +102,7 @@ namespace zeus::md::itch
     uint8_t _ipo_flag;
     uint8_t _luld_reference_price_tier;
     uint8_t _etp_flag;
-    uint32_t _etp_leverage_factor;
+    be_u32 _etp_leverage_factor;
     uint8_t _inverse_indicator;
   } __attribute__((packed));
 
@@ -93,6 +110,8 @@ namespace zeus::md::itch
 
   struct stock_trading_action_message
   {
+    static constexpr message_type type{message_type::STOCK_TRADING_ACTION_MESSAGE};
+
     using reason_t = char[4];
     
     message_header _header;
@@ -106,6 +125,8 @@ namespace zeus::md::itch
 
   struct reg_sho_indicator_message
   {
+    static constexpr message_type type{message_type::REG_SHO_INDICATOR_MESSAGE};
+
     message_header _header;
     stock_t _stock;
     uint8_t _reg_sho_action;
@@ -115,6 +136,8 @@ namespace zeus::md::itch
 
   struct market_participant_position_message
   {
+    static constexpr message_type type{message_type::MARKET_PARTICIPANT_POSITION_MESSAGE};
+
     using mpid_t = char[4];
     
     message_header _header;
@@ -129,16 +152,20 @@ namespace zeus::md::itch
 
   struct mwcb_decline_level_message
   {
+    static constexpr message_type type{message_type::MWCB_DECLINE_LEVEL_MESSAGE};
+
     message_header _header;
-    math::fixed<8>::underlying_t _level_one;
-    math::fixed<8>::underlying_t _level_two;
-    math::fixed<8>::underlying_t _level_three;
+    be_price8_t _level_one;
+    be_price8_t _level_two;
+    be_price8_t _level_three;
   } __attribute__((packed));
 
   static_assert(sizeof(mwcb_decline_level_message) == 35);
 
   struct mwcb_status_message
   {
+    static constexpr message_type type{message_type::MWCB_STATUS_MESSAGE};
+
     message_header _header;
     uint8_t _breached_level;
   } __attribute__((packed));
@@ -147,29 +174,35 @@ namespace zeus::md::itch
 
   struct ipo_quoting_period_update_message
   {
+    static constexpr message_type type{message_type::IPO_QUOTING_PERIOD_MESSAGE};
+
     message_header _header;
     stock_t _stock;
-    uint32_t _ipo_quoting_release_time;
+    be_u32 _ipo_quoting_release_time;
     uint8_t _ipo_quotation_release_qualifier;
-    math::fixed<4, int32_t>::underlying_t _ipo_price;
+    be_price4_t _ipo_price;
   } __attribute__((packed));
 
   static_assert(sizeof(ipo_quoting_period_update_message) == 28);
 
   struct luld_auction_collar_message
   {
+    static constexpr message_type type{message_type::LULD_AUCTION_COLLAR_MESSAGE};
+
     message_header _header;
     stock_t _stock;
-    math::fixed<4, int32_t>::underlying_t _auction_collar_reference_price;
-    math::fixed<4, int32_t>::underlying_t _upper_auction_collar_reference_price;
-    math::fixed<4, int32_t>::underlying_t _lower_auction_collar_reference_price;
-    uint32_t _auction_collar_extension;
+    be_price4_t _auction_collar_reference_price;
+    be_price4_t _upper_auction_collar_reference_price;
+    be_price4_t _lower_auction_collar_reference_price;
+    be_u32 _auction_collar_extension;
   } __attribute__((packed));
 
   static_assert(sizeof(luld_auction_collar_message) == 35);
 
   struct operational_halt_message
   {
+    static constexpr message_type type{message_type::OPERATIONAL_HALT_MESSAGE};
+
     message_header _header;
     stock_t _stock;
     uint8_t _market_code;
@@ -180,18 +213,22 @@ namespace zeus::md::itch
 
   struct add_order_no_mpid_message
   {
+    static constexpr message_type type{message_type::ADD_ORDER_NO_MPID_MESSAGE};
+
     message_header _header;
-    uint64_t _order_reference_number;
+    be_u64 _order_reference_number;
     uint8_t _buy_sell_indicator;
-    uint32_t _shares;
+    be_u32 _shares;
     stock_t _stock;
-    math::fixed<4, int32_t>::underlying_t _price;
+    be_price4_t _price;
   } __attribute__((packed));
 
   static_assert(sizeof(add_order_no_mpid_message) == 36);
 
   struct add_order_with_mpid_message
   {
+    static constexpr message_type type{message_type::ADD_ORDER_WITH_MPID_MESSAGE};
+
     using attribution_t = char[4];
     
     add_order_no_mpid_message _add_order;
@@ -202,71 +239,85 @@ namespace zeus::md::itch
 
   struct order_executed_message
   {
+    static constexpr message_type type{message_type::ORDER_EXECUTED_MESSAGE};
+
     message_header _header;
-    uint64_t _order_reference_number;
-    uint32_t _executed_shares;
-    uint64_t _match_number;
+    be_u64 _order_reference_number;
+    be_u32 _executed_shares;
+    be_u64 _match_number;
   } __attribute__((packed));
 
   static_assert(sizeof(order_executed_message) == 31);
 
   struct order_executed_with_price_message
   {
+    static constexpr message_type type{message_type::ORDER_EXECUTED_WITH_PRICE};
+
     order_executed_message _order_executed_message;
     uint8_t _printable;
-    math::fixed<4, int32_t>::underlying_t _price;
+    be_price4_t _price;
   } __attribute__((packed));
 
   static_assert(sizeof(order_executed_with_price_message) == 36);
 
   struct order_cancel_message
   {
+    static constexpr message_type type{message_type::ORDER_CANCEL_MESSAGE};
+
     message_header _header;
-    uint64_t _order_reference_number;
-    uint32_t _cancelled_shares;
+    be_u64 _order_reference_number;
+    be_u32 _cancelled_shares;
   } __attribute__((packed));
 
   static_assert(sizeof(order_cancel_message) == 23);
 
   struct order_delete_message
   {
+    static constexpr message_type type{message_type::ORDER_DELETE_MESSAGE};
+
     message_header _header;
-    uint64_t _order_reference_number;
+    be_u64 _order_reference_number;
   } __attribute__((packed));
 
   static_assert(sizeof(order_delete_message) == 19);
 
   struct order_replace_message
   {
+    static constexpr message_type type{message_type::ORDER_REPLACE_MESSAGE};
+
     message_header _header;
-    uint64_t _original_order_reference_number;
-    uint64_t _new_order_reference_number;
-    uint32_t _shares;
-    math::fixed<4, int32_t>::underlying_t _price;
+    be_u64 _original_order_reference_number;
+    be_u64 _new_order_reference_number;
+    be_u32 _shares;
+    be_price4_t _price;
   } __attribute__((packed));
 
   static_assert(sizeof(order_replace_message) == 35);
 
   struct trade_message
   {
+    static constexpr message_type type{message_type::TRADE_MESSAGE};
+
     message_header _header;
-    uint64_t _original_order_reference_number;
+    be_u64 _original_order_reference_number;
     uint8_t _buy_sell_indicator;
-    uint32_t _shares;
+    be_u32 _shares;
     stock_t _stock;
-    math::fixed<4, int32_t>::underlying_t _price;
-    uint64_t _match_number;
+    be_price4_t _price;
+    be_u64 _match_number;
   } __attribute__((packed));
 
   static_assert(sizeof(trade_message) == 44);
 
   struct cross_trade_message
   {
+    static constexpr message_type type{message_type::CROSS_TRADE_MESSAGE};
+
     message_header _header;
-    uint64_t _shares;
+    be_u64 _shares;
     stock_t _stock;
-    math::fixed<4, int32_t>::underlying_t _cross_price;
-    uint64_t _match_number;
+    be_price4_t _cross_price;
+    be_u64 _match_number;
     uint8_t _cross_type;
   } __attribute__((packed));
 
@@ -274,22 +325,26 @@ namespace zeus::md::itch
 
   struct broken_trade_message
   {
+    static constexpr message_type type{message_type::BROKEN_TRADE_MESSAGE};
+
     message_header _header;
-    uint64_t _match_number;
+    be_u64 _match_number;
   } __attribute__((packed));
 
   static_assert(sizeof(broken_trade_message) == 19);
 
   struct net_order_imbalance_indicator_message
   {
+    static constexpr message_type type{message_type::NET_ORDER_IMBALANCE_INDICATOR_MESSAGE};
+
     message_header _header;
-    uint64_t _paired_shares;
-    uint64_t _imbalance_shares;
+    be_u64 _paired_shares;
+    be_u64 _imbalance_shares;
     uint8_t _imbalance_direction;
     stock_t _stock;
-    math::fixed<4, int32_t>::underlying_t _far_price;
-    math::fixed<4, int32_t>::underlying_t _near_price;
-    math::fixed<4, int32_t>::underlying_t _current_reference_price;
+    be_price4_t _far_price;
+    be_price4_t _near_price;
+    be_price4_t _current_reference_price;
     uint8_t _cross_type;
     uint8_t _price_variation_indicator;
   } __attribute__((packed));
@@ -304,4 +359,33 @@ namespace zeus::md::itch
   };
 
   static_assert(sizeof(retail_price_improvement_indicator_message) == 20);
+
+  template<typename... Messages>
+  struct type_list
+  {
+  };
+
+  /* Every message type we understand. The feed builds its dispatch table from this list. */
+  using message_types = type_list<
+    system_event_message,
+    stock_directory_message,
+    stock_trading_action_message,
+    reg_sho_indicator_message,
+    market_participant_position_message,
+    mwcb_decline_level_message,
+    mwcb_status_message,
+    ipo_quoting_period_update_message,
+    luld_auction_collar_message,
+    operational_halt_message,
+    add_order_no_mpid_message,
+    add_order_with_mpid_message,
+    order_executed_message,
+    order_executed_with_price_message,
+    order_cancel_message,
+    order_delete_message,
+    order_replace_message,
+    trade_message,
+    cross_trade_message,
+    broken_trade_message,
+    net_order_imbalance_indicator_message>;
 }
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "md/itch/receiver.h"
+#include "system/utilities.h"
+
+namespace zeus::md::itch
+{
+  /**
+   * Open a non-blocking UDP socket for market data, shared by the socket receivers. The socket is bound to the group and
+   * joins it if it is a multicast address, and asks for busy polling, kernel timestamps and a large receive buffer.
+   *
+   * @param group The multicast group, or a unicast address, to listen on
+   * @param port The port to listen on, or 0 to have one picked
+   * @param interface The address of the interface to join the group on
+   * @param bound_port Set to the port the socket ends up bound to
+   * @returns The socket
+   */
+  int open_udp_socket(std::string const &group, uint16_t port, std::string const &interface, uint16_t &bound_port);
+
+  /**
+   * Reads datagrams from a UDP socket, usually a multicast group, a whole batch at a time.
+   *
+   * Each recvmmsg call fills a preallocated arena with as many datagrams as are waiting, up to the batch size, and they
+   * are then handed out one by one without another syscall. On a bursty open the syscall cost is spread over the whole
+   * batch. The socket asks for busy polling and kernel receive timestamps, which are only decoded if they are asked for.
+   */
+  class udp_receiver
+  {
+  public:
+    /* Enough for any MoldUDP64 packet that fits in a standard MTU */
+    static constexpr std::size_t max_packet_size{2048};
+    static constexpr std::size_t default_batch_size{64};
+
+    /**
+     * @param group The multicast group, or a unicast address, to listen on
+     * @param port The port to listen on, or 0 to have one picked
+     * @param interface The address of the interface to join the group on
+     * @param batch_size The most datagrams to read per syscall
+     */
+    udp_receiver(std::string const &group, uint16_t port, std::string const &interface = "0.0.0.0",
+                 std::size_t batch_size = default_batch_size);
+    ~udp_receiver();
+
+    udp_receiver(udp_receiver const &) = delete;
+    udp_receiver &operator=(udp_receiver const &) = delete;
+
+    /***/
+    std::span<std::byte const> receive() noexcept
+    {
+      if (_next == _received && !_fill())
+      {
+        return {};
+      }
+
+      std::size_t const index = _next++;
+      return {_arena.data() + index * max_packet_size, _headers[index].msg_len};
+    }
+
+    /** The time the kernel received the last datagram handed out, in nanoseconds since the epoch, or 0 if unknown */
+    [[nodiscard]] uint64_t timestamp() const noexcept;
+
+    /** The port the socket is bound to */
+    [[nodiscard]] uint16_t port() const noexcept { return _port; }
+
+    /** The number of recvmmsg calls that returned data */
+    [[nodiscard]] std::size_t batches() const noexcept { return _batches; }
+
+    /** The number of datagrams read */
+    [[nodiscard]] std::size_t packets() const noexcept { return _packets; }
+
+    /** The number of datagrams that were too large for the arena and were cut short */
+    [[nodiscard]] std::size_t truncated() const noexcept { return _truncated; }
+
+  private:
+    /** Read the next batch into the arena */
+    bool _fill() noexcept;
+
+  private:
+    /** \brief The socket */
+    int _fd{-1};
+
+    /** \brief The port the socket is bound to */
+    uint16_t _port{0};
+
+    /** \brief Backing storage for a whole batch of datagrams, one fixed size slot each */
+    std::vector<std::byte> _arena;
+
+    /** \brief Backing storage for the control messages that carry the timestamps */
+    std::vector<std::byte> _control;
+
+    /** \brief One scatter entry per slot */
+    std::vector<iovec> _iovecs;
+
+    /** \brief One header per slot, as recvmmsg wants them */
+    std::vector<mmsghdr> _headers;
+
+    /** \brief The number of datagrams in the current batch */
+    std::size_t _received{0};
+
+    /** \brief The next datagram in the current batch to hand out */
+    std::size_t _next{0};
+
+    /** \brief Statistics */
+    std::size_t _batches{0};
+    std::size_t _packets{0};
+    std::size_t _truncated{0};
+  };
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <linux/io_uring.h>
+
+#include "md/itch/receiver.h"
+#include "system/utilities.h"
+
+namespace zeus::md::itch
+{
+  /**
+   * Reads datagrams from a UDP socket through io_uring, without a syscall per read.
+   *
+   * A single multishot recv stays armed on the socket, and the kernel picks a buffer for each datagram from a ring of
+   * buffers we have registered with it up front. Completions are reaped straight from the shared completion ring, so in
+   * the steady state a poll is a couple of loads. The recv only has to be rearmed if the kernel runs out of buffers.
+   *
+   * Each datagram is handed out in the buffer the kernel wrote it into, and the buffer is given back to the kernel on
+   * the following call.
+   */
+  class uring_receiver
+  {
+  public:
+    static constexpr std::size_t max_packet_size{2048};
+    static constexpr std::size_t default_buffer_count{256};
+
+    /**
+     * @param group The multicast group, or a unicast address, to listen on
+     * @param port The port to listen on, or 0 to have one picked
+     * @param interface The address of the interface to join the group on
+     * @param buffer_count The number of datagram buffers to register, which must be a power of two
+     */
+    uring_receiver(std::string const &group, uint16_t port, std::string const &interface = "0.0.0.0",
+                   std::size_t buffer_count = default_buffer_count);
+    ~uring_receiver();
+
+    uring_receiver(uring_receiver const &) = delete;
+    uring_receiver &operator=(uring_receiver const &) = delete;
+
+    /***/
+    std::span<std::byte const> receive() noexcept
+    {
+      _recycle();
+      if (__unlikely(!_armed))
+      {
+        _arm();
+      }
+
+      uint32_t const head = *_cq_head;
+      if (head == std::atomic_ref<uint32_t>{*_cq_tail}.load(std::memory_order_acquire))
+      {
+        /* Completions that did not fit in the ring are held back by the kernel until we ask for them */
+        if (__unlikely(std::atomic_ref<uint32_t>{*_sq_flags}.load(std::memory_order_relaxed) & IORING_SQ_CQ_OVERFLOW))
+        {
+          _flush_overflow();
+        }
+        return {};
+      }
+
+      io_uring_cqe const &completion = _cqes[head & _cq_mask];
+      int const result = completion.res;
+      uint32_t const flags = completion.flags;
+      std::atomic_ref<uint32_t>{*_cq_head}.store(head + 1, std::memory_order_release);
+
+      /* The multishot recv has stopped, most likely because we ran out of buffers. Rearm it on the next poll. */
+      if (__unlikely(!(flags & IORING_CQE_F_MORE)))
+      {
+        _armed = false;
+      }
+
+      if (__unlikely(!(flags & IORING_CQE_F_BUFFER)))
+      {
+        return {};
+      }
+
+      /* Hold the buffer until the next poll. An empty or failed datagram just hands it straight back. */
+      _held = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+      ++_packets;
+      if (__unlikely(result <= 0))
+      {
+        return {};
+      }
+
+      return {_buffers + std::size_t{_held} * max_packet_size, static_cast<std::size_t>(result)};
+    }
+
+    /** The port the socket is bound to */
+    [[nodiscard]] uint16_t port() const noexcept { return _port; }
+
+    /** The number of completions that carried a datagram */
+    [[nodiscard]] std::size_t packets() const noexcept { return _packets; }
+
+    /** The number of times the recv had to be submitted, including the first */
+    [[nodiscard]] std::size_t submissions() const noexcept { return _submissions; }
+
+  private:
+    static constexpr uint16_t _no_buffer{0xFFFF};
+
+    /** Give the buffer of the last datagram back to the kernel */
+    void _recycle() noexcept
+    {
+      if (_held == _no_buffer)
+      {
+        return;
+      }
+
+      /* Index from the start of the ring rather than through bufs. The kernel header declares it with an empty struct in
+       * front, which takes up a byte in C++ and pushes the array 8 bytes off from where the kernel expects it. */
+      io_uring_buf &buffer = reinterpret_cast<io_uring_buf *>(_buffer_ring)[_buffer_tail & _buffer_mask];
+      buffer.addr = reinterpret_cast<uint64_t>(_buffers + std::size_t{_held} * max_packet_size);
+      buffer.len = max_packet_size;
+      buffer.bid = _held;
+      std::atomic_ref<uint16_t>{_buffer_ring->tail}.store(++_buffer_tail, std::memory_order_release);
+      _held = _no_buffer;
+    }
+
+    /** Unmap and close everything we have set up so far */
+    void _close() noexcept;
+
+    /** Submit the multishot recv */
+    [[using gnu: cold, noinline]] void _arm() noexcept;
+
+    /** Have the kernel move any overflowed completions into the ring */
+    [[using gnu: cold, noinline]] void _flush_overflow() noexcept;
+
+  private:
+    /** \brief The socket */
+    int _socket{-1};
+
+    /** \brief The port the socket is bound to */
+    uint16_t _port{0};
+
+    /** \brief The io_uring instance */
+    int _ring{-1};
+
+    /** \brief The shared submission and completion ring mappings, which may be one and the same */
+    void *_sq_mapping{nullptr};
+    std::size_t _sq_mapping_size{0};
+    void *_cq_mapping{nullptr};
+    std::size_t _cq_mapping_size{0};
+
+    /** \brief The submission queue */
+    io_uring_sqe *_sqes{nullptr};
+    std::size_t _sqes_size{0};
+    uint32_t *_sq_head{nullptr};
+    uint32_t *_sq_tail{nullptr};
+    uint32_t *_sq_flags{nullptr};
+    uint32_t *_sq_array{nullptr};
+    uint32_t _sq_mask{0};
+
+    /** \brief The completion queue */
+    uint32_t *_cq_head{nullptr};
+    uint32_t *_cq_tail{nullptr};
+    io_uring_cqe *_cqes{nullptr};
+    uint32_t _cq_mask{0};
+
+    /** \brief The ring through which we provide buffers to the kernel */
+    io_uring_buf_ring *_buffer_ring{nullptr};
+    std::size_t _buffer_ring_size{0};
+    uint16_t _buffer_tail{0};
+    uint16_t _buffer_mask{0};
+
+    /** \brief The datagram buffers, one fixed size slot each */
+    std::byte *_buffers{nullptr};
+    std::size_t _buffers_size{0};
+
+    /** \brief The buffer of the last datagram handed out, which the caller may still be reading */
+    uint16_t _held{_no_buffer};
+
+    /** \brief Whether the multishot recv is in flight */
+    bool _armed{false};
+
+    /** \brief Statistics */
+    std::size_t _packets{0};
+    std::size_t _submissions{0};
+  };
+}
\ No newline at end of file
@@ -1,46 +1,99 @@
 #pragma once
 
+#include "core/types.h"
+#include "md/order_pool.h"
+
 namespace zeus::md
 {
   /**
-   * A stateless representation of a level in a LOB. It may seem a little silly now, but the interface will be useful
-   * for when L3 support is added.
-   *
-   * TODO(jhannah): Add a structure to store the orders.
-   *   - Design a solution that is copy-free from receiving from the handler to moving into the book. Only reclaim these
-   *     buffers when the order is executed or canceled.
+   * A level in a LOB. Alongside the aggregate quantity, the level holds its resting orders in FIFO time priority as an
+   * intrusive, doubly linked list of nodes living in the book's order pool. Every operation is O(1).
    */
   class level {
   public:
     level() = default;
     ~level() = default;
 
-    /***/
-    void add_order(core::quantity_t qty) {
-      _quantity += qty;
+    /** Append an order to the back of the queue */
+    void add_order(order_pool &pool, order_handle_t handle) {
+      order_node &node = pool[handle];
+      node._prev = _tail;
+      node._next = invalid_order_handle;
+
+      if (_tail != invalid_order_handle)
+      {
+        pool[_tail]._next = handle;
+      }
+      else
+      {
+        _head = handle;
+      }
+
+      _tail = handle;
+      _quantity += node._qty;
+      ++_count;
     }
 
-    /***/
-    void remove_order(core::quantity_t const& qty) {
-      _quantity -= qty;
+    /** Unlink an order from the queue, removing its remaining quantity from the level */
+    void remove_order(order_pool &pool, order_handle_t handle) {
+      order_node &node = pool[handle];
+
+      if (node._prev != invalid_order_handle)
+      {
+        pool[node._prev]._next = node._next;
+      }
+      else
+      {
+        _head = node._next;
+      }
+
+      if (node._next != invalid_order_handle)
+      {
+        pool[node._next]._prev = node._prev;
+      }
+      else
+      {
+        _tail = node._prev;
+      }
+
+      _quantity -= node._qty;
+      --_count;
     }
 
-    void cancel_order(core::quantity_t const& qty)
+    /** Reduce the quantity of an order. It keeps its place in the queue. */
+    void cancel_order(order_node &node, core::quantity_t const& qty)
     {
+      node._qty -= qty;
       _quantity -= qty;
     }
 
     /***/
-    void execute_order(core::quantity_t const& qty) {
+    void execute_order(order_node &node, core::quantity_t const& qty) {
+      node._qty -= qty;
       _quantity -= qty;
     }
 
     /** I'm really torn whether to just expose the data member instead of a trivial getter. */
     [[nodiscard]] core::quantity_t quantity() const noexcept { return _quantity; }
 
+    /** The number of orders resting in this level */
+    [[nodiscard]] std::size_t count() const noexcept { return _count; }
+
+    /** The order at the front of the queue, or invalid_order_handle if the level is empty */
+    [[nodiscard]] order_handle_t front() const noexcept { return _head; }
+
+    /** The order at the back of the queue, or invalid_order_handle if the level is empty */
+    [[nodiscard]] order_handle_t back() const noexcept { return _tail; }
+
   private:
-    /* Here, we store the current open quantity of the level. While the design is so unsophisticated, this abstraction
-     * is quite useless, but it will be handy later on. */
+    /* Here, we store the current open quantity of the level, so L2 queries never need to walk the queue */
     core::quantity_t _quantity{0};
+
+    /* The number of orders in the queue */
+    std::size_t _count{0};
+
+    /* The front and back of the FIFO queue */
+    order_handle_t _head{invalid_order_handle};
+    order_handle_t _tail{invalid_order_handle};
   };
 }
\ No newline at end of file
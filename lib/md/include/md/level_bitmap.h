@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "system/utilities.h"
+
+namespace zeus::md
+{
+  /**
+   * A two-tier occupancy bitmap over the levels of a price window, one bit per level.
+   *
+   * The summary word holds one bit per non-zero word of the bitmap, so finding the nearest occupied level in either
+   * direction is at most two tzcnt/lzcnt instructions, no matter how sparse the window is. This supports windows of up
+   * to 64 * 64 = 4096 levels.
+   */
+  class level_bitmap
+  {
+  private:
+    static constexpr std::size_t _bits{64};
+
+  public:
+    /* Returned when there is no occupied level in the requested direction */
+    static constexpr std::size_t npos{std::numeric_limits<std::size_t>::max()};
+
+    /* The largest window that can be summarised by a single word */
+    static constexpr std::size_t max_size{_bits * _bits};
+
+    level_bitmap() = default;
+    ~level_bitmap() = default;
+
+    /***/
+    explicit level_bitmap(std::size_t size) : _size(size), _words((size + _bits - 1) / _bits, 0)
+    {
+      utility::zassert_ndebug(size <= max_size, "Level bitmap is too large.");
+    }
+
+    /** Mark a level as occupied */
+    void set(std::size_t index) noexcept
+    {
+      _words[index / _bits] |= uint64_t{1} << (index % _bits);
+      _summary |= uint64_t{1} << (index / _bits);
+    }
+
+    /** Mark a level as empty */
+    void clear(std::size_t index) noexcept
+    {
+      uint64_t &word = _words[index / _bits];
+      word &= ~(uint64_t{1} << (index % _bits));
+      if (word == 0)
+      {
+        _summary &= ~(uint64_t{1} << (index / _bits));
+      }
+    }
+
+    /** Mark every level as empty */
+    void reset() noexcept
+    {
+      std::fill(_words.begin(), _words.end(), 0);
+      _summary = 0;
+    }
+
+    /** Whether a level is occupied */
+    [[nodiscard]] bool test(std::size_t index) const noexcept
+    {
+      return (_words[index / _bits] >> (index % _bits)) & 1;
+    }
+
+    /** The highest occupied level strictly below index, or npos */
+    [[nodiscard]] std::size_t highest_below(std::size_t index) const noexcept
+    {
+      std::size_t const word = index / _bits;
+      uint64_t const below = _words[word] & ((uint64_t{1} << (index % _bits)) - 1);
+      if (below != 0)
+      {
+        return word * _bits + _bits - 1 - __builtin_clzll(below);
+      }
+
+      uint64_t const summary = _summary & ((uint64_t{1} << word) - 1);
+      if (summary == 0)
+      {
+        return npos;
+      }
+
+      std::size_t const found = _bits - 1 - __builtin_clzll(summary);
+      return found * _bits + _bits - 1 - __builtin_clzll(_words[found]);
+    }
+
+    /** The lowest occupied level strictly above index, or npos */
+    [[nodiscard]] std::size_t lowest_above(std::size_t index) const noexcept
+    {
+      std::size_t const next = index + 1;
+      if (next >= _size)
+      {
+        return npos;
+      }
+
+      std::size_t const word = next / _bits;
+      uint64_t const above = _words[word] & (~uint64_t{0} << (next % _bits));
+      if (above != 0)
+      {
+        return word * _bits + __builtin_ctzll(above);
+      }
+
+      /* Shift in two steps, since shifting a 64-bit word by 64 is undefined */
+      uint64_t const summary = _summary & ((~uint64_t{0} << word) << 1);
+      if (summary == 0)
+      {
+        return npos;
+      }
+
+      std::size_t const found = __builtin_ctzll(summary);
+      return found * _bits + __builtin_ctzll(_words[found]);
+    }
+
+    /** The number of levels covered by the bitmap */
+    [[nodiscard]] std::size_t size() const noexcept { return _size; }
+
+  private:
+    /** \brief The number of levels covered by the bitmap */
+    std::size_t _size{0};
+
+    /** \brief One bit per word of the bitmap, set if that word has any level occupied */
+    uint64_t _summary{0};
+
+    /** \brief One bit per level */
+    std::vector<uint64_t> _words{};
+  };
+}
\ No newline at end of file
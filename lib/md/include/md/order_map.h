@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "core/types.h"
+#include "system/utilities.h"
+
+namespace zeus::md
+{
+  /**
+   * A flat, open-addressing hash map keyed on the exchange order ID.
+   *
+   * The table is a power of two in size and uses linear probing, so a lookup is usually a single cache line. Erasing
+   * uses backward shift deletion, so there are no tombstones and probe lengths do not degrade over a trading day. The
+   * invalid order ID is reserved to mark an empty slot.
+   */
+  template<typename V>
+  class order_map
+  {
+  public:
+    struct slot
+    {
+      core::ordid_t _key{core::invalid_ordid};
+      V _value{};
+    };
+
+  private:
+    /* Grow once the table is more than 3/4 full */
+    static constexpr std::size_t _max_load_numerator{3};
+    static constexpr std::size_t _max_load_denominator{4};
+
+    /* Fibonacci hashing, taking the upper bits of the product as the index. Order IDs are dense and near-sequential,
+     * so this spreads them far better than a plain mask would. */
+    static constexpr uint64_t _golden_ratio{0x9E3779B97F4A7C15ULL};
+
+  public:
+    order_map() : order_map(0) {}
+    ~order_map() = default;
+
+    /**
+     * @param capacity The number of entries the map should hold without growing, e.g. yesterday's peak order count
+     */
+    explicit order_map(std::size_t capacity)
+    {
+      _rehash(std::bit_ceil(std::max<std::size_t>(capacity * _max_load_denominator / _max_load_numerator + 1, 16)));
+    }
+
+    /**
+     * Look up an order
+     *
+     * @param key The order ID
+     * @returns A pointer to the value, or nullptr if the order is not in the map
+     */
+    [[nodiscard]] V *find(core::ordid_t key) noexcept
+    {
+      for (std::size_t index = _home(key);; index = (index + 1) & _mask)
+      {
+        slot &current = _slots[index];
+        if (current._key == key)
+        {
+          return &current._value;
+        }
+
+        if (current._key == core::invalid_ordid)
+        {
+          return nullptr;
+        }
+      }
+    }
+
+    /***/
+    [[nodiscard]] V const *find(core::ordid_t key) const noexcept
+    {
+      return const_cast<order_map *>(this)->find(key);
+    }
+
+    /**
+     * Insert an order if it is not already present
+     *
+     * @param key The order ID
+     * @param args The arguments used to construct the value
+     * @returns A pointer to the value, and whether it was inserted
+     */
+    template<typename... Args>
+    std::pair<V *, bool> try_emplace(core::ordid_t key, Args &&... args)
+    {
+      utility::zassert(key != core::invalid_ordid, "The invalid order ID is reserved.");
+
+      if (__unlikely((_size + 1) * _max_load_denominator > _slots.size() * _max_load_numerator))
+      {
+        _rehash(_slots.size() * 2);
+      }
+
+      for (std::size_t index = _home(key);; index = (index + 1) & _mask)
+      {
+        slot &current = _slots[index];
+        if (current._key == key)
+        {
+          return {&current._value, false};
+        }
+
+        if (current._key == core::invalid_ordid)
+        {
+          current._key = key;
+          current._value = V(std::forward<Args>(args)...);
+          ++_size;
+          return {&current._value, true};
+        }
+      }
+    }
+
+    /**
+     * Remove an order, shifting any displaced entries back towards their home slot
+     *
+     * @param key The order ID
+     * @returns Whether the order was present
+     */
+    bool erase(core::ordid_t key) noexcept
+    {
+      std::size_t hole = _home(key);
+      for (;; hole = (hole + 1) & _mask)
+      {
+        if (_slots[hole]._key == key)
+        {
+          break;
+        }
+
+        if (_slots[hole]._key == core::invalid_ordid)
+        {
+          return false;
+        }
+      }
+
+      /* Pull back every entry in the cluster that would still be reachable from its home slot via the hole */
+      for (std::size_t index = (hole + 1) & _mask; _slots[index]._key != core::invalid_ordid; index = (index + 1) & _mask)
+      {
+        std::size_t const home = _home(_slots[index]._key);
+        if (((index - home) & _mask) >= ((index - hole) & _mask))
+        {
+          _slots[hole] = _slots[index];
+          hole = index;
+        }
+      }
+
+      _slots[hole]._key = core::invalid_ordid;
+      --_size;
+      return true;
+    }
+
+    /** Hint that we are about to look up an order, so the slot can be pulled into cache ahead of time */
+    void prefetch(core::ordid_t key) const noexcept
+    {
+      __builtin_prefetch(&_slots[_home(key)]);
+    }
+
+    /** The number of orders in the map */
+    [[nodiscard]] std::size_t size() const noexcept { return _size; }
+
+    /** The number of slots in the table */
+    [[nodiscard]] std::size_t capacity() const noexcept { return _slots.size(); }
+
+    /** The whole table, for taking a snapshot */
+    [[nodiscard]] std::span<slot const> slots() const noexcept { return _slots; }
+
+  private:
+    /** The slot an order ID hashes to */
+    [[nodiscard]] std::size_t _home(core::ordid_t key) const noexcept
+    {
+      return static_cast<std::size_t>((key * _golden_ratio) >> _shift);
+    }
+
+    /** Resize the table and reinsert every entry. This is the only place the map allocates. */
+    [[using gnu: cold, noinline]] void _rehash(std::size_t capacity)
+    {
+      std::vector<slot> slots(capacity);
+      std::swap(slots, _slots);
+      _mask = capacity - 1;
+      _shift = static_cast<uint8_t>(64 - std::countr_zero(capacity));
+
+      for (slot const &current : slots)
+      {
+        if (current._key == core::invalid_ordid)
+        {
+          continue;
+        }
+
+        std::size_t index = _home(current._key);
+        while (_slots[index]._key != core::invalid_ordid)
+        {
+          index = (index + 1) & _mask;
+        }
+        _slots[index] = current;
+      }
+    }
+
+  private:
+    /** \brief The table itself */
+    std::vector<slot> _slots{};
+
+    /** \brief The table size minus one, used to wrap the probe sequence */
+    std::size_t _mask{0};
+
+    /** \brief The shift that maps the hashed key onto the table size */
+    uint8_t _shift{0};
+
+    /** \brief The number of occupied slots */
+    std::size_t _size{0};
+  };
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "core/types.h"
+#include "system/utilities.h"
+
+namespace zeus::md
+{
+  /* Orders are linked by a 32-bit handle rather than a pointer, so the pool may grow without invalidating the queues */
+  using order_handle_t = uint32_t;
+  constexpr order_handle_t invalid_order_handle = std::numeric_limits<order_handle_t>::max();
+
+  /** An intrusive node representing a single resting order in the FIFO queue of a level */
+  struct order_node
+  {
+    /** \brief The exchange order ID of this order */
+    core::ordid_t _order_id{core::invalid_ordid};
+
+    /** \brief The open quantity of this order */
+    core::quantity_t _qty{0};
+
+    /** \brief The order ahead of this one in the queue */
+    order_handle_t _prev{invalid_order_handle};
+
+    /** \brief The order behind this one in the queue. Doubles as the free list link while the node is unused. */
+    order_handle_t _next{invalid_order_handle};
+  };
+
+  /**
+   * A preallocated pool of order nodes. Released nodes are threaded onto a free list and are reused before the pool
+   * grows, so in the steady state acquiring/releasing an order is O(1) and never touches the heap.
+   */
+  class order_pool
+  {
+  public:
+    order_pool() = default;
+    ~order_pool() = default;
+
+    /***/
+    explicit order_pool(std::size_t capacity)
+    {
+      _nodes.reserve(capacity);
+    }
+
+    /**
+     * Rebuild a pool from a snapshot, keeping every handle as it was
+     *
+     * @param nodes Every node, in use and free
+     * @param free The head of the free list
+     * @param capacity The number of nodes to preallocate storage for
+     */
+    order_pool(std::span<order_node const> nodes, order_handle_t free, std::size_t capacity) : _free(free)
+    {
+      _nodes.reserve(std::max(capacity, nodes.size()));
+      _nodes.assign(nodes.begin(), nodes.end());
+    }
+
+    /**
+     * Take a node from the pool and initialise it with the order information
+     *
+     * @param order_id The exchange order ID
+     * @param qty The open quantity of the order
+     * @returns A handle to the node
+     */
+    [[nodiscard]] order_handle_t acquire(core::ordid_t order_id, core::quantity_t qty)
+    {
+      order_handle_t handle = _free;
+      if (__likely(handle != invalid_order_handle))
+      {
+        _free = _nodes[handle]._next;
+        _nodes[handle] = order_node{._order_id = order_id, ._qty = qty};
+        return handle;
+      }
+
+      /* The free list is exhausted. This will only allocate if we have outgrown the preallocated capacity. */
+      utility::zassert(_nodes.size() < invalid_order_handle, "Order pool is exhausted.");
+      _nodes.push_back(order_node{._order_id = order_id, ._qty = qty});
+      return static_cast<order_handle_t>(_nodes.size() - 1);
+    }
+
+    /**
+     * Return a node to the pool. The node must already have been unlinked from its level.
+     *
+     * @param handle The handle of the node to release
+     */
+    void release(order_handle_t handle)
+    {
+      order_node &node = _nodes[handle];
+      node._order_id = core::invalid_ordid;
+      node._prev = invalid_order_handle;
+      node._next = _free;
+      _free = handle;
+    }
+
+    /***/
+    [[nodiscard]] order_node &operator[](order_handle_t handle) noexcept { return _nodes[handle]; }
+
+    /***/
+    [[nodiscard]] order_node const &operator[](order_handle_t handle) const noexcept { return _nodes[handle]; }
+
+    /** The number of nodes that can be held before the pool needs to touch the heap */
+    [[nodiscard]] std::size_t capacity() const noexcept { return _nodes.capacity(); }
+
+    /** Every node, in use or free, for taking a snapshot */
+    [[nodiscard]] std::span<order_node const> nodes() const noexcept { return _nodes; }
+
+    /** The head of the free list, for taking a snapshot */
+    [[nodiscard]] order_handle_t free_list() const noexcept { return _free; }
+
+  private:
+    /** \brief The backing storage for all nodes, both in use and free */
+    std::vector<order_node> _nodes{};
+
+    /** \brief The head of the free list */
+    order_handle_t _free{invalid_order_handle};
+  };
+}
\ No newline at end of file
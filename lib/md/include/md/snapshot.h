@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "system/exception.h"
+
+namespace zeus::md
+{
+  /* A run of values in a snapshot, addressed by its offset from the start of the image so the image can live anywhere */
+  struct snapshot_section
+  {
+    uint64_t _offset{0};
+    uint64_t _count{0};
+  };
+
+  /**
+   * Builds a snapshot image in memory. Values are copied in byte for byte, each aligned to its type, and are referred to
+   * by offset rather than by address.
+   */
+  class snapshot_writer
+  {
+  public:
+    /**
+     * Append a run of values
+     *
+     * @returns Where they were written
+     */
+    template<typename T>
+    snapshot_section write(std::span<T const> values)
+    {
+      static_assert(std::is_trivially_copyable_v<T>, "Snapshots copy values byte by byte.");
+      static_assert(std::has_unique_object_representations_v<T>,
+                    "Padding would carry whatever was in memory into the snapshot, so spell it out as a member.");
+
+      std::size_t const offset = (_image.size() + alignof(T) - 1) / alignof(T) * alignof(T);
+      _image.resize(offset + values.size_bytes());
+      if (!values.empty())
+      {
+        std::memcpy(_image.data() + offset, values.data(), values.size_bytes());
+      }
+      return {offset, values.size()};
+    }
+
+    /**
+     * Append a single value
+     *
+     * @returns The offset it was written at
+     */
+    template<typename T>
+    uint64_t write(T const &value)
+    {
+      return write(std::span<T const>{&value, 1})._offset;
+    }
+
+    /** Overwrite a value that was written earlier, e.g. a header that is only complete once everything else is */
+    template<typename T>
+    void patch(uint64_t offset, T const &value) noexcept
+    {
+      static_assert(std::is_trivially_copyable_v<T>, "Snapshots copy values byte by byte.");
+      static_assert(std::has_unique_object_representations_v<T>,
+                    "Padding would carry whatever was in memory into the snapshot, so spell it out as a member.");
+      std::memcpy(_image.data() + offset, &value, sizeof(T));
+    }
+
+    /***/
+    [[nodiscard]] std::span<std::byte const> bytes() const noexcept { return _image; }
+
+    /** Write the image to a file. It is written alongside and renamed into place, so a reader never sees half of it. */
+    void save(std::filesystem::path const &path) const;
+
+  private:
+    /** \brief The image so far */
+    std::vector<std::byte> _image{};
+  };
+
+  /**
+   * Reads values out of a snapshot image in place. Every read is checked against the bounds of the image, so a corrupt
+   * or truncated snapshot is reported rather than read past.
+   */
+  class snapshot_reader
+  {
+  public:
+    /** Read an image that is already in memory. The memory is not owned by the reader. */
+    explicit snapshot_reader(std::span<std::byte const> image) noexcept : _image(image)
+    {
+    }
+
+    /** Map a snapshot file with a single mmap */
+    explicit snapshot_reader(std::filesystem::path const &path);
+
+    ~snapshot_reader();
+
+    snapshot_reader(snapshot_reader const &) = delete;
+    snapshot_reader &operator=(snapshot_reader const &) = delete;
+
+    /***/
+    template<typename T>
+    [[nodiscard]] std::span<T const> read(snapshot_section section) const
+    {
+      static_assert(std::is_trivially_copyable_v<T>, "Snapshots copy values byte by byte.");
+      static_assert(std::has_unique_object_representations_v<T>,
+                    "Padding would carry whatever was in memory into the snapshot, so spell it out as a member.");
+
+      if (section._offset % alignof(T) != 0 || section._offset > _image.size() ||
+          section._count > (_image.size() - section._offset) / sizeof(T))
+      {
+        zeus::system::throw_runtime_error("snapshot_reader", __func__,
+                                          "Section at offset " + std::to_string(section._offset) +
+                                          " does not fit in the snapshot.");
+      }
+
+      return {reinterpret_cast<T const *>(_image.data() + section._offset), static_cast<std::size_t>(section._count)};
+    }
+
+    /***/
+    template<typename T>
+    [[nodiscard]] T const &read(uint64_t offset) const
+    {
+      return read<T>(snapshot_section{._offset = offset, ._count = 1}).front();
+    }
+
+    /***/
+    [[nodiscard]] std::span<std::byte const> bytes() const noexcept { return _image; }
+
+  private:
+    /** \brief The whole image */
+    std::span<std::byte const> _image;
+
+    /** \brief The mapping, if the reader made one */
+    void *_mapping{nullptr};
+  };
+}
\ No newline at end of file
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <initializer_list>
+#include <span>
+#include <utility>
+
+#include "core/types.h"
+#include "math/fastmod.h"
+#include "system/utilities.h"
+
+namespace zeus::md
+{
+  /**
+   * Maps prices onto a contiguous ladder of indices, where the tick size may vary by price band (e.g. Reg NMS sub-dollar
+   * pricing, or a MiFID II tick size regime).
+   *
+   * The ladder is continuous across bands, so the book can treat it exactly as if there were a single tick size. Each
+   * band precomputes its fastmod divisor, and the band is chosen by counting thresholds rather than branching, so the
+   * conversion is constant time.
+   */
+  class tick_table
+  {
+  public:
+    /* Real tick regimes have a handful of bands. Bounding it lets the band search be fully unrolled. */
+    static constexpr std::size_t max_bands{8};
+
+    struct band
+    {
+      /** \brief The lowest price in the band */
+      core::price_t _from;
+
+      /** \brief The tick size within the band */
+      core::price_t _tick_size;
+    };
+
+    /**
+     * A table with a single tick size for every price
+     *
+     * @param tick_size The minimum price increment
+     */
+    tick_table(core::price_t tick_size) : tick_table({band{._from = core::price_t{0}, ._tick_size = tick_size}})
+    {
+    }
+
+    /**
+     * @param bands The bands in ascending price order. The first band must start at zero, and each band must span a
+     *   whole number of its ticks.
+     */
+    tick_table(std::initializer_list<band> bands) : tick_table(std::span<band const>{bands.begin(), bands.size()})
+    {
+    }
+
+    /***/
+    explicit tick_table(std::span<band const> bands)
+    {
+      utility::zassert_ndebug(bands.size() != 0 && bands.size() <= max_bands, "Invalid number of tick bands.");
+      utility::zassert_ndebug(bands.begin()->_from == core::price_t{0}, "The first tick band must start at zero.");
+
+      /* Unused bands start at the maximum price, so they are never counted when searching for a band */
+      _from.fill(std::numeric_limits<core::price_t::underlying_t>::max());
+      _base_index.fill(std::numeric_limits<std::size_t>::max());
+
+      std::size_t base_index{0};
+      for (band const &current : bands)
+      {
+        if (_bands != 0)
+        {
+          auto const span = static_cast<uint64_t>(current._from.underlying() - _from[_bands - 1]);
+          utility::zassert_ndebug(span % _divisors[_bands - 1] == 0, "A tick band must span a whole number of ticks.");
+          base_index += span / _divisors[_bands - 1];
+        }
+
+        _from[_bands] = current._from.underlying();
+        _base_index[_bands] = base_index;
+        _divisors[_bands] = math::lemire_fastmod{static_cast<uint64_t>(current._tick_size.underlying())};
+        ++_bands;
+      }
+    }
+
+    /**
+     * Convert a price to its index on the ladder
+     *
+     * @param price The price, which must lie on the grid of its band
+     * @returns The ladder index
+     */
+    [[nodiscard]] std::size_t index(core::price_t price) const noexcept
+    {
+      std::size_t const current = _band(_from, price.underlying());
+      return _base_index[current] + static_cast<uint64_t>(price.underlying() - _from[current]) / _divisors[current];
+    }
+
+    /**
+     * Convert a ladder index back to its price
+     *
+     * @param index The ladder index
+     * @returns The price at that index
+     */
+    [[nodiscard]] core::price_t price(std::size_t index) const noexcept
+    {
+      std::size_t const current = _band(_base_index, index);
+      auto const offset = static_cast<core::price_t::underlying_t>((index - _base_index[current]) *
+                                                                   _divisors[current].denominator());
+      return core::price_t::from_underlying(_from[current] + offset);
+    }
+
+    /** The number of bands in use */
+    [[nodiscard]] std::size_t bands() const noexcept { return _bands; }
+
+    /** A band in use, as it was given to the constructor */
+    [[nodiscard]] band at(std::size_t index) const noexcept
+    {
+      return band{._from = core::price_t::from_underlying(_from[index]),
+                  ._tick_size = core::price_t::from_underlying(
+                    static_cast<core::price_t::underlying_t>(_divisors[index].denominator()))};
+    }
+
+  private:
+    /** The fastmod divisors have no default state, so fill the unused bands with a placeholder */
+    template<std::size_t... Bands>
+    static std::array<math::lemire_fastmod, max_bands> _placeholder_divisors(std::index_sequence<Bands...>)
+    {
+      return {((void) Bands, math::lemire_fastmod{std::numeric_limits<uint64_t>::max()})...};
+    }
+
+    /** Find the band a value falls into by counting the band starts at or below it */
+    template<typename T>
+    [[nodiscard]] std::size_t _band(std::array<T, max_bands> const &starts, T value) const noexcept
+    {
+      std::size_t band{0};
+      for (std::size_t index = 1; index < max_bands; ++index)
+      {
+        band += starts[index] <= value;
+      }
+      return band;
+    }
+
+  private:
+    /** \brief The number of bands in use */
+    std::size_t _bands{0};
+
+    /** \brief The lowest price of each band */
+    std::array<core::price_t::underlying_t, max_bands> _from{};
+
+    /** \brief The ladder index of the lowest price of each band */
+    std::array<std::size_t, max_bands> _base_index{};
+
+    /** \brief The tick size of each band, optimised for division */
+    std::array<math::lemire_fastmod, max_bands> _divisors{_placeholder_divisors(std::make_index_sequence<max_bands>{})};
+  };
+}
\ No newline at end of file
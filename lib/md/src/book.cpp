@@ -1,174 +1,734 @@
 #include "md/book.h"
 #include "md/itch/types.h"
+#include "md/snapshot.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace zeus::md
 {
+  namespace
+  {
+    /* A level outside of the window, and its price in ticks */
+    struct spilled_level
+    {
+      uint64_t _ticks;
+      md::level _level;
+    };
+
+    /* The fixed size part of a book in a snapshot. Everything of variable size is a section of its own. */
+    struct book_image
+    {
+      struct side_image
+      {
+        uint64_t _top;
+        uint64_t _base;
+        snapshot_section _window;
+        snapshot_section _spill;
+      };
+
+      std::array<md::tick_table::band, md::tick_table::max_bands> _bands;
+      uint64_t _band_count;
+      std::array<side_image, 2> _sides;
+      snapshot_section _orders;
+      uint64_t _order_capacity;
+      snapshot_section _order_map;
+      uint64_t _peak_orders;
+      uint64_t _update_sequence;
+      uint64_t _quote_sequence;
+      md::quote _published;
+      order_handle_t _free_order;
+
+      /* Spelled out, as the snapshot writer will not copy padding */
+      uint32_t _padding;
+    };
+
+    [[noreturn]] void reject(std::string reason)
+    {
+      zeus::system::throw_runtime_error("book", "book", std::move(reason));
+    }
+
+    /* The tick table asserts on bad bands, so they are checked before it is rebuilt from them */
+    md::tick_table restore_ticks(book_image const &image)
+    {
+      if (image._band_count == 0 || image._band_count > md::tick_table::max_bands ||
+          image._bands[0]._from != core::price_t{0})
+      {
+        reject("Invalid tick bands.");
+      }
+
+      std::span<md::tick_table::band const> const bands{image._bands.data(), image._band_count};
+      for (std::size_t index = 0; index < bands.size(); ++index)
+      {
+        if (bands[index]._tick_size.underlying() <= 0 ||
+            (index != 0 && (bands[index]._from.underlying() <= bands[index - 1]._from.underlying() ||
+                            (bands[index]._from.underlying() - bands[index - 1]._from.underlying()) %
+                              bands[index - 1]._tick_size.underlying() != 0)))
+        {
+          reject("Invalid tick bands.");
+        }
+      }
+      return md::tick_table{bands};
+    }
+
+    /**
+     * Walk the queue of a saved level, making sure every link stays inside the pool and no order sits in two queues.
+     * Each order found is recorded against the level it rests in, so the order map can be checked against the queues.
+     *
+     * @returns The number of orders in the queue
+     */
+    std::size_t check_queue(md::level const &level, std::span<order_node const> nodes, std::size_t ticks,
+                            core::order_side side, std::vector<order_info> &resting)
+    {
+      if (level.count() > nodes.size())
+      {
+        reject("A level counts more orders than the pool holds.");
+      }
+
+      if (level.count() != 0 && ticks > order_info::max_ticks)
+      {
+        reject("A level is too far up the tick ladder.");
+      }
+
+      std::size_t length = 0;
+      order_handle_t previous = invalid_order_handle;
+      for (order_handle_t handle = level.front(); handle != invalid_order_handle; handle = nodes[handle]._next)
+      {
+        if (handle >= nodes.size() || nodes[handle]._prev != previous || ++length > level.count() ||
+            resting[handle]._node != invalid_order_handle)
+        {
+          reject("A level links to an order outside of the pool.");
+        }
+        resting[handle] = order_info{ticks, side, handle};
+        previous = handle;
+      }
+
+      if (length != level.count() || previous != level.back())
+      {
+        reject("A level does not hold the orders it counts.");
+      }
+      return length;
+    }
+  }
+
+  /***/
+  book::book(md::tick_table const &ticks, std::size_t order_capacity, std::size_t window_levels)
+    : _ticks(ticks), _orders(order_capacity), _order_level_mapping(order_capacity)
+  {
+    utility::zassert_ndebug(window_levels >= 4, "The price window must hold at least 4 levels.");
+
+    for (book_side &side : _book)
+    {
+      side._window.resize(window_levels);
+      side._scratch.resize(window_levels);
+      side._occupied = md::level_bitmap{window_levels};
+    }
+
+    /* We want an empty buy/sell price to be represented by the numerical min/max index/price */
+    _book[0]._top = std::numeric_limits<size_t>::min();
+    _book[1]._top = std::numeric_limits<size_t>::max();
+  }
+
+  /***/
+  book::book(md::snapshot_reader const &reader, uint64_t offset)
+    : book(restore_ticks(reader.read<book_image>(offset)), 0)
+  {
+    book_image const &image = reader.read<book_image>(offset);
+    std::span<order_node const> const nodes = reader.read<order_node>(image._orders);
+    if (nodes.size() >= invalid_order_handle)
+    {
+      reject("The order pool is too large.");
+    }
+
+    /* Nothing in the snapshot is trusted to point inside the pool, so every queue is walked before we adopt it */
+    std::vector<order_info> resting(nodes.size());
+    std::size_t live = 0;
+    for (std::size_t index = 0; index < _book.size(); ++index)
+    {
+      book_side &side = _book[index];
+      book_image::side_image const &saved = image._sides[index];
+
+      std::span<md::level const> const window = reader.read<md::level>(saved._window);
+      if (window.size() < 4 || window.size() > md::level_bitmap::max_size)
+      {
+        reject("Invalid window of " + std::to_string(window.size()) + " levels.");
+      }
+
+      /* An empty side keeps its top at the sentinel, anything else must be inside the window */
+      bool const empty = saved._top == (index == 0 ? std::numeric_limits<uint64_t>::min()
+                                                   : std::numeric_limits<uint64_t>::max());
+      if (saved._base > std::numeric_limits<uint64_t>::max() - window.size() ||
+          (!empty && saved._top - saved._base >= window.size()))
+      {
+        reject("The top of the book is outside of its window.");
+      }
+
+      core::order_side const order_side = index == 0 ? core::order_side::BUY : core::order_side::SELL;
+      side._top = saved._top;
+      side._base = saved._base;
+      side._window.assign(window.begin(), window.end());
+      side._scratch.assign(window.size(), md::level{});
+
+      /* The bitmap is derived from the window, so it is rebuilt rather than saved */
+      side._occupied = md::level_bitmap{window.size()};
+      for (std::size_t level = 0; level < window.size(); ++level)
+      {
+        live += check_queue(window[level], nodes, saved._base + level, order_side, resting);
+        if (window[level].count() != 0)
+        {
+          side._occupied.set(level);
+        }
+      }
+
+      /* Spilled levels were saved in order, so each one goes at the end of the map */
+      for (spilled_level const &spilled : reader.read<spilled_level>(saved._spill))
+      {
+        if (spilled._ticks - saved._base < window.size() ||
+            (!side._spill.empty() && spilled._ticks <= side._spill.rbegin()->first))
+        {
+          reject("A spilled level overlaps another level.");
+        }
+
+        live += check_queue(spilled._level, nodes, spilled._ticks, order_side, resting);
+        side._spill.emplace_hint(side._spill.end(), spilled._ticks, spilled._level);
+      }
+    }
+
+    /* Whatever is not resting in a level must be on the free list */
+    std::size_t free = 0;
+    for (order_handle_t handle = image._free_order; handle != invalid_order_handle; handle = nodes[handle]._next)
+    {
+      if (handle >= nodes.size() || ++free > nodes.size())
+      {
+        reject("The free list runs outside of the order pool.");
+      }
+    }
+
+    if (live + free != nodes.size())
+    {
+      reject("The order pool does not match the levels.");
+    }
+
+    /* The table is rebuilt rather than adopted, so its layout is never trusted. Every entry must name an order in the
+     * level it claims, and every resting order must have exactly one entry. */
+    _order_level_mapping = md::order_map<md::order_info>{std::max<std::size_t>(image._order_capacity, live)};
+    for (order_map<order_info>::slot const &slot : reader.read<order_map<order_info>::slot>(image._order_map))
+    {
+      if (slot._key == core::invalid_ordid)
+      {
+        continue;
+      }
+
+      order_handle_t const node = slot._value._node;
+      if (node >= nodes.size() || nodes[node]._order_id != slot._key || resting[node]._node != node ||
+          resting[node]._level != slot._value._level)
+      {
+        reject("The order map points at an order that is not in the book.");
+      }
+
+      if (!_order_level_mapping.try_emplace(slot._key, resting[node]).second)
+      {
+        reject("The order map holds an order twice.");
+      }
+    }
+
+    if (_order_level_mapping.size() != live)
+    {
+      reject("The order map does not match the levels.");
+    }
+
+    _orders = md::order_pool{nodes, image._free_order, image._order_capacity};
+    _peak_orders = image._peak_orders;
+    _update_sequence = image._update_sequence;
+    _quote_sequence = image._quote_sequence;
+    _published.store(image._published);
+  }
+
   /***/
-  book::book(core::price_t tick_size) : _tick_size(tick_size.underlying())
+  uint64_t book::save(md::snapshot_writer &writer) const
   {
-    /* We want an empty sell price to be represented by the numerical max index/price */
-    _book[1].first = std::numeric_limits<size_t>::max();
+    book_image image{};
+    image._band_count = _ticks.bands();
+    for (std::size_t band = 0; band < _ticks.bands(); ++band)
+    {
+      image._bands[band] = _ticks.at(band);
+    }
+
+    for (std::size_t index = 0; index < _book.size(); ++index)
+    {
+      book_side const &side = _book[index];
+      book_image::side_image &saved = image._sides[index];
+
+      saved._top = side._top;
+      saved._base = side._base;
+      saved._window = writer.write(std::span<md::level const>{side._window});
+
+      std::vector<spilled_level> spilled;
+      spilled.reserve(side._spill.size());
+      for (auto const &[ticks, level] : side._spill)
+      {
+        spilled.push_back(spilled_level{._ticks = ticks, ._level = level});
+      }
+      saved._spill = writer.write(std::span<spilled_level const>{spilled});
+    }
+
+    image._orders = writer.write(_orders.nodes());
+    image._order_capacity = _orders.capacity();
+    image._free_order = _orders.free_list();
+    image._order_map = writer.write(_order_level_mapping.slots());
+    image._peak_orders = _peak_orders;
+    image._update_sequence = _update_sequence;
+    image._quote_sequence = _quote_sequence;
+    image._published = _published.load();
+    return writer.write(image);
   }
 
   /***/
-  void book::add(order_add const &order)
+  bool book::add(order_add const &order)
   {
-    /* TODO(jhannah): Is this better than a branch? Should we load by value here, then again by reference _only_ in
-     *   the case that we need to actually move the spread prices? */
-    auto&[top_index, levels] = _book[math::signof(static_cast<int64_t>(order._side))];
+    book_side &side = _side(order._side);
 
     /* Calculate our index into this half of the book */
-    const std::size_t ticks_in_price = order._price.underlying() / _tick_size;
-    md::level &level = levels[ticks_in_price % _max_levels];
+    const std::size_t ticks_in_price = _ticks.index(order._price);
 
-    /* Add this order information to the map */
-    _order_level_mapping.try_emplace(order._order_id, &level, order._quantity);
+    /* Update the spread information. If the touch has moved out of place in the window, drag the window with it before
+     * we look up the level. */
+    bool improves = order._side == core::order_side::BUY ? ticks_in_price > side._top : ticks_in_price < side._top;
+    if (improves)
+    {
+      side._top = ticks_in_price;
+      if (__unlikely(!_is_central(side, order._side, ticks_in_price)))
+      {
+        _recenter(side, order._side, ticks_in_price);
+      }
+    }
+
+    /* Near the touch, this is a direct index. We also need to mark the level as occupied. */
+    std::size_t const offset = ticks_in_price - side._base;
+    bool const in_window = offset < side._window.size();
+    md::level &level = __likely(in_window) ? side._window[offset] : side._spill[ticks_in_price];
+    if (__likely(in_window))
+    {
+      side._occupied.set(offset);
+    }
 
-    /* Add the order */
-    level.add_order(order._quantity);
+    /* Take a node from the pool and add this order information to the map */
+    order_handle_t node = _orders.acquire(order._order_id, order._quantity);
+    _order_level_mapping.try_emplace(order._order_id, ticks_in_price, order._side, node);
 
-    /* Update the spread information */
-    top_index = order._side == core::order_side::BUY ? std::max(top_index, ticks_in_price)
-                                                     : std::min(top_index, ticks_in_price);
+    /* Add the order to the back of the queue */
+    level.add_order(_orders, node);
+    _peak_orders = std::max(_peak_orders, _order_level_mapping.size());
+    if (_updates != nullptr)
+    {
+      _stream(order._side, ticks_in_price);
+    }
+
+    /* Either a new best price, or more quantity at the best price */
+    return ticks_in_price == side._top;
   }
 
   /***/
-  void book::cancel(order_canceled const &order)
+  bool book::cancel(order_canceled const &order)
   {
     /* Find the order in the level and remove it */
-    md::order_info& info = _order_level_mapping[order._order_id];
-    utility::zassert(info._level != nullptr, "Level is nullptr.");
-
-    /* Remove the order */
-    info._level->cancel_order(order._shares_cancelled);
+    md::order_info const *found = _order_level_mapping.find(order._order_id);
+    if (__unlikely(found == nullptr))
+    {
+      return _unknown_order();
+    }
+    md::order_info const info = *found;
 
-    /* We need to adjust the working quantity of this order, or we will double-account when it gets filled/removed */
-    info._qty -= order._shares_cancelled;
+    /* Reduce the working quantity of the order. If nothing is left, it no longer holds a place in the queue. */
+    order_node &node = _orders[info._node];
+    _level(_side(info.side()), info.ticks()).cancel_order(node, order._shares_cancelled);
+    if (node._qty == 0)
+    {
+      _release_order(order._order_id, info);
+    }
+    if (_updates != nullptr)
+    {
+      _stream(info.side(), info.ticks());
+    }
 
     /* Check if the top of book has changed */
-    _resolve_book_side(_level_to_side(*info._level), info);
+    return _resolve_book_side(info);
   }
 
   /***/
-  void book::remove(order_removed const &order)
+  bool book::remove(order_removed const &order)
   {
     /* Find the order in the level and remove it */
-    md::order_info const &info = _order_level_mapping[order._order_id];
-    utility::zassert(info._level != nullptr, "Level is nullptr.");
+    md::order_info const *found = _order_level_mapping.find(order._order_id);
+    if (__unlikely(found == nullptr))
+    {
+      return _unknown_order();
+    }
+    md::order_info const info = *found;
 
     /* Remove the order */
-    info._level->remove_order(info._qty);
+    _release_order(order._order_id, info);
+    if (_updates != nullptr)
+    {
+      _stream(info.side(), info.ticks());
+    }
 
     /* Check if the top of book has changed */
-    _resolve_book_side(_level_to_side(*info._level), info);
+    return _resolve_book_side(info);
   }
 
-  void book::replace(order_replaced const &order)
+  bool book::replace(order_replaced const &order)
   {
-    md::order_info const &info = _order_level_mapping[order._original_order_id];
-    utility::zassert(info._level != nullptr, "Level is nullptr.");
+    md::order_info const *info = _order_level_mapping.find(order._original_order_id);
+    if (__unlikely(info == nullptr))
+    {
+      /* We do not know the side, so we cannot add the new order either. Anything that follows for it is unknown too. */
+      return _unknown_order();
+    }
 
-    core::order_side side = _level_to_side(*info._level);
+    core::order_side side = info->side();
 
     /* Add the new order */
     order_add order_add{._order_id = order._new_order_id, ._quantity = order._quantity, ._price = order._price, ._side = side};
-    add(order_add);
+    bool const added_at_top = add(order_add);
 
     /* Remove the order */
     order_removed order_remove{._order_id = order._original_order_id};
-    remove(order_remove);
+    bool const removed_at_top = remove(order_remove);
+    return added_at_top || removed_at_top;
   }
 
   /***/
-  void book::execute(order_executed const &order)
+  bool book::execute(order_executed const &order)
   {
     /* Find the order in the level and remove it */
-    md::order_info &info = _order_level_mapping[order._order_id];
-    utility::zassert(info._level != nullptr, "Level is nullptr.");
-
-    /* Execute the order */
-    info._level->execute_order(order._shares_executed);
+    md::order_info const *found = _order_level_mapping.find(order._order_id);
+    if (__unlikely(found == nullptr))
+    {
+      return _unknown_order();
+    }
+    md::order_info const info = *found;
 
-    /* We need to adjust the working quantity of this order, or we will double-account when it gets filled/removed */
-    info._qty -= order._shares_executed;
+    /* Execute the order. A complete fill takes it out of the queue. */
+    order_node &node = _orders[info._node];
+    _level(_side(info.side()), info.ticks()).execute_order(node, order._shares_executed);
+    if (node._qty == 0)
+    {
+      _release_order(order._order_id, info);
+    }
+    if (_updates != nullptr)
+    {
+      _stream(info.side(), info.ticks());
+    }
 
     /* We may have executed the total quantity. Check if the spread has moved. */
-    _resolve_book_side(_level_to_side(*info._level), info);
+    return _resolve_book_side(info);
   }
 
   /***/
-  void book::execute_with_price(order_executed_with_price const &order)
+  bool book::execute_with_price(order_executed_with_price const &order)
   {
     /* Right now, we do not care about the executed price, we just need to change the level where the order lives */
-    execute(order._order_executed);
+    return execute(order._order_executed);
   }
 
   /***/
   std::pair<core::price_t, core::quantity_t> book::best_bid() const
   {
-    auto&[top_index, levels] = _book[0];
-    if (__unlikely(top_index == std::numeric_limits<size_t>::min()))
+    book_side const &side = _book[0];
+    if (__unlikely(side._top == std::numeric_limits<size_t>::min()))
     {
       return {core::invalid_price, core::quantity_t{0}};
     }
 
-    return {core::price_t::from_underlying(top_index * _tick_size.denominator()),
-            core::quantity_t{levels[top_index % _max_levels].quantity()}};
+    return {_ticks.price(side._top),
+            core::quantity_t{side._window[side._top - side._base].quantity()}};
   }
 
   /***/
   std::pair<core::price_t, core::quantity_t> book::best_ask() const
   {
-    auto&[top_index, levels] = _book[1];
-    if (__unlikely(top_index == std::numeric_limits<size_t>::max()))
+    book_side const &side = _book[1];
+    if (__unlikely(side._top == std::numeric_limits<size_t>::max()))
     {
       return {core::invalid_price, core::quantity_t{0}};
     }
 
-    return {core::price_t::from_underlying(top_index * _tick_size.denominator()),
-            core::quantity_t{levels[top_index % _max_levels].quantity()}};
+    return {_ticks.price(side._top),
+            core::quantity_t{side._window[side._top - side._base].quantity()}};
+  }
+
+  /***/
+  std::size_t book::depth(core::order_side side, std::size_t levels,
+                          std::span<std::pair<core::price_t, core::quantity_t>> out) const
+  {
+    book_side const &half = _side(side);
+    bool const buy = side == core::order_side::BUY;
+    std::size_t const wanted = std::min(levels, out.size());
+
+    /* An empty side has no top to start from */
+    if (half._top == (buy ? std::numeric_limits<std::size_t>::min() : std::numeric_limits<std::size_t>::max()))
+    {
+      return 0;
+    }
+
+    /* The top of book always lives in the window, so walk the occupied levels outwards from there */
+    std::size_t filled{0};
+    std::size_t offset = half._top - half._base;
+    while (filled < wanted && offset != md::level_bitmap::npos)
+    {
+      out[filled++] = {_ticks.price(half._base + offset), half._window[offset].quantity()};
+      offset = buy ? half._occupied.highest_below(offset) : half._occupied.lowest_above(offset);
+    }
+
+    /* Then carry on into the levels that have spilled beyond the window, which are all further from the touch */
+    if (buy)
+    {
+      for (auto it = std::make_reverse_iterator(half._spill.lower_bound(half._base));
+           filled < wanted && it != half._spill.rend(); ++it)
+      {
+        out[filled++] = {_ticks.price(it->first), it->second.quantity()};
+      }
+    }
+    else
+    {
+      for (auto it = half._spill.lower_bound(half._base + half._window.size());
+           filled < wanted && it != half._spill.end(); ++it)
+      {
+        out[filled++] = {_ticks.price(it->first), it->second.quantity()};
+      }
+    }
+
+    return filled;
+  }
+
+  /***/
+  void book::publish(uint64_t timestamp)
+  {
+    auto const [bid_price, bid_quantity] = best_bid();
+    auto const [ask_price, ask_quantity] = best_ask();
+    _published.store(md::quote{
+      ._bid_price = bid_price,
+      ._bid_quantity = bid_quantity,
+      ._ask_price = ask_price,
+      ._ask_quantity = ask_quantity,
+      ._sequence = ++_quote_sequence,
+      ._timestamp = timestamp
+    });
+  }
+
+  /***/
+  std::pair<std::size_t, core::quantity_t> book::queue_position(core::ordid_t order_id) const
+  {
+    md::order_info const *info = _order_level_mapping.find(order_id);
+    utility::zassert(info != nullptr, "Unknown order.");
+
+    /* Walk the queue from the front. This is not a hot path, so we do not maintain a running position per order. */
+    std::size_t orders_ahead{0};
+    core::quantity_t qty_ahead{0};
+    md::level const &level = _level(_side(info->side()), info->ticks());
+    for (order_handle_t handle = level.front(); handle != info->_node; handle = _orders[handle]._next)
+    {
+      utility::zassert(handle != invalid_order_handle, "Order is not resting in its level.");
+      qty_ahead += _orders[handle]._qty;
+      ++orders_ahead;
+    }
+
+    return {orders_ahead, qty_ahead};
   }
 
   /** If quantity is executed or removed, we need to check if the spread price has moved */
-  void book::_resolve_book_side(core::order_side side, order_info const &info)
+  bool book::_resolve_book_side(order_info const &info)
   {
-    auto side_multiplier = static_cast<int64_t>(side);
-    auto&[top_index, levels] = _book[math::signof(side_multiplier)];
+    book_side &side = _side(info.side());
+
+    /* Anything away from the touch leaves the top of book alone. The top of book always lives in the window, so only
+     * look at the level once we know it is the top. */
+    if (info.ticks() != side._top)
+    {
+      return false;
+    }
+
+    if (side._window[side._top - side._base].quantity() != 0)
+    {
+      return true;
+    }
 
-    /* TODO(jhannah): Curious how much impact the short-circuit branching would have here? */
-    bool empty_level = info._level->quantity() == 0;
-    bool top_of_book = info._level == &levels[top_index];
-    if (empty_level & top_of_book)
+    /* Search the window for the next best level. The bitmap makes this constant time, however sparse the window is. */
+    std::size_t const offset = info.side() == core::order_side::BUY ? side._occupied.highest_below(side._top - side._base)
+                                                                     : side._occupied.lowest_above(side._top - side._base);
+    if (__likely(offset != md::level_bitmap::npos))
     {
-      /* In a liquid market, it's very likely that there will be volume in the level behind */
-      std::size_t next_index = (top_index -= side_multiplier) % _max_levels;
-      if (__likely(levels[next_index].quantity() != 0))
+      side._top = side._base + offset;
+      if (__unlikely(!_is_central(side, info.side(), side._top)))
       {
-        return;
+        _recenter(side, info.side(), side._top);
       }
+      return true;
+    }
+
+    /* There's no liquidity left in the window. Fall back to the best level that has spilled. */
+    if (!side._spill.empty())
+    {
+      side._top = info.side() == core::order_side::BUY ? side._spill.rbegin()->first : side._spill.begin()->first;
+      _recenter(side, info.side(), side._top);
+      return true;
+    }
+
+    /* The book is empty on this side */
+    side._top = info.side() == core::order_side::BUY ? std::numeric_limits<std::size_t>::min()
+                                                      : std::numeric_limits<std::size_t>::max();
+    return true;
+  }
+
+  /***/
+  void book::_release_order(core::ordid_t order_id, order_info const &info)
+  {
+    book_side &side = _side(info.side());
+    md::level &level = _level(side, info.ticks());
+    level.remove_order(_orders, info._node);
+    _orders.release(info._node);
 
-      /* There's no liquidity in the level behind. Perform a linear search to look for it. */
-      for (std::size_t count = 1; count < _max_levels; ++count)
+    /* Keep the occupancy bitmap up to date, and the spill map sparse */
+    if (level.count() == 0)
+    {
+      std::size_t const offset = info.ticks() - side._base;
+      if (__likely(offset < side._window.size()))
       {
-        std::size_t running_index = (top_index -= side_multiplier) % _max_levels;
-        if (levels[running_index].quantity() != 0)
-        {
-          return;
-        }
+        side._occupied.clear(offset);
       }
+      else
+      {
+        side._spill.erase(info.ticks());
+      }
+    }
+
+    /* This shifts entries within the map, so the caller must hold the info by value */
+    _order_level_mapping.erase(order_id);
+  }
 
-      /* The book is empty on this side */
-      top_index = side == core::order_side::BUY ? std::numeric_limits<std::size_t>::min()
-                                                : std::numeric_limits<std::size_t>::max();
+  /***/
+  void book::_stream(core::order_side side, std::size_t ticks)
+  {
+    /* An emptied level may have already been erased from the spill map, so look without creating it */
+    book_side const &half = _side(side);
+    std::size_t const offset = ticks - half._base;
+    core::quantity_t quantity{0};
+    if (__likely(offset < half._window.size()))
+    {
+      quantity = half._window[offset].quantity();
     }
+    else if (auto it = half._spill.find(ticks); it != half._spill.end())
+    {
+      quantity = it->second.quantity();
+    }
+
+    _updates->write(md::level_update{
+      ._sequence = ++_update_sequence,
+      ._price = _ticks.price(ticks),
+      ._quantity = quantity,
+      ._instrument = _instrument,
+      ._side = side
+    });
   }
 
   /***/
-  core::order_side book::_level_to_side(md::level const &level) const
+  bool book::_unknown_order() noexcept
   {
-    /* This is a hacky way of converting a level to a side, but it beats storing it in a map/level/order_info */
-    bool is_sell_side = std::addressof(level) >= std::addressof(_book[1].second.front());
-    return is_sell_side ? core::order_side::SELL : core::order_side::BUY;
+    ++_unknown_orders;
+    return false;
   }
 
+  /***/
+  md::level &book::_level(book_side &side, std::size_t ticks)
+  {
+    std::size_t const offset = ticks - side._base;
+    if (__likely(offset < side._window.size()))
+    {
+      return side._window[offset];
+    }
+
+    return side._spill[ticks];
+  }
+
+  /***/
+  md::level const &book::_level(book_side const &side, std::size_t ticks) const
+  {
+    std::size_t const offset = ticks - side._base;
+    if (__likely(offset < side._window.size()))
+    {
+      return side._window[offset];
+    }
+
+    return side._spill.at(ticks);
+  }
+
+  /***/
+  bool book::_is_central(book_side const &side, core::order_side order_side, std::size_t ticks) noexcept
+  {
+    /* Unsigned wrap-around folds the below-the-window case into the comparisons. The touch is kept in the half of the
+     * window nearest the spread, and a window pinned at zero cannot move any lower, so it is as well placed as it can be
+     * for anything below that. */
+    std::size_t const half = side._window.size() / 2;
+    std::size_t const offset = ticks - side._base;
+    if (order_side == core::order_side::BUY)
+    {
+      return offset < side._window.size() && (offset >= half || side._base == 0);
+    }
+    return offset < half;
+  }
+
+  /***/
+  void book::_recenter(book_side &side, core::order_side order_side, std::size_t ticks)
+  {
+    /* Nothing ever rests on the far side of the touch, so a window centred on it would leave half of it empty. Instead
+     * the touch goes a quarter of the way in from the edge nearest the spread, and the rest of the window covers the
+     * depth behind it. */
+    std::size_t const width = side._window.size();
+    std::size_t const behind = order_side == core::order_side::BUY ? width - width / 4 : width / 4;
+    std::size_t const base = ticks > behind ? ticks - behind : 0;
+
+    /* Keep the levels that are still in range, and spill the ones that are not */
+    std::fill(side._scratch.begin(), side._scratch.end(), md::level{});
+    for (std::size_t offset = 0; offset < width; ++offset)
+    {
+      md::level const &level = side._window[offset];
+      if (level.count() == 0)
+      {
+        continue;
+      }
+
+      std::size_t const level_ticks = side._base + offset;
+      if (level_ticks - base < width)
+      {
+        side._scratch[level_ticks - base] = level;
+      }
+      else
+      {
+        side._spill.emplace(level_ticks, level);
+      }
+    }
+
+    /* Pull in any spilled levels that the window now covers */
+    for (auto it = side._spill.lower_bound(base); it != side._spill.end() && it->first - base < width;)
+    {
+      side._scratch[it->first - base] = it->second;
+      it = side._spill.erase(it);
+    }
+
+    std::swap(side._window, side._scratch);
+    side._base = base;
+
+    /* Recentering is rare enough that we can just rebuild the bitmap */
+    side._occupied.reset();
+    for (std::size_t offset = 0; offset < width; ++offset)
+    {
+      if (side._window[offset].count() != 0)
+      {
+        side._occupied.set(offset);
+      }
+    }
+  }
 }
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "md/itch/file_receiver.h"
+#include "system/exception.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace zeus::md::itch
+{
+  /***/
+  file_receiver::file_receiver(std::filesystem::path const &path, std::size_t max_messages, uint64_t until)
+    : _max_messages(max_messages), _until(until)
+  {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+      std::string msg = std::string{"Failed to open "} + path.string() + ": " + std::strerror(errno);
+      zeus::system::throw_runtime_error("file_receiver", __func__, std::move(msg));
+    }
+
+    struct stat status{};
+    if (::fstat(fd, &status) == -1)
+    {
+      std::string msg = std::string{"Failed to stat file: "} + std::strerror(errno);
+      ::close(fd);
+      zeus::system::throw_runtime_error("file_receiver", __func__, std::move(msg));
+    }
+
+    /* mmap rejects an empty mapping, and there is nothing to replay anyway */
+    _size = static_cast<std::size_t>(status.st_size);
+    if (_size != 0)
+    {
+      _mapping = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (_mapping == MAP_FAILED)
+      {
+        std::string msg = std::string{"Failed to map file: "} + std::strerror(errno);
+        ::close(fd);
+        zeus::system::throw_runtime_error("file_receiver", __func__, std::move(msg));
+      }
+
+      /* Let the kernel read ahead aggressively and drop pages behind us. Hugepages are only a hint: file-backed THP
+       * depends on the filesystem and kernel config, so a refusal is not an error. */
+      ::madvise(_mapping, _size, MADV_SEQUENTIAL);
+      ::madvise(_mapping, _size, MADV_HUGEPAGE);
+
+      _messages = buffer_receiver{{static_cast<std::byte const *>(_mapping), _size}};
+    }
+
+    /* The mapping keeps its own reference to the file */
+    ::close(fd);
+  }
+
+  /***/
+  file_receiver::~file_receiver()
+  {
+    if (_mapping != nullptr)
+    {
+      ::munmap(_mapping, _size);
+    }
+  }
+}
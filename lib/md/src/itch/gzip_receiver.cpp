@@ -0,0 +1,76 @@
+#include "md/itch/gzip_receiver.h"
+#include "system/exception.h"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <xmmintrin.h>
+#include <zlib.h>
+
+namespace zeus::md::itch
+{
+  namespace
+  {
+    /* Inflate in slices, so the feed thread can start on a chunk while the next one is being inflated */
+    constexpr std::size_t chunk_size{std::size_t{1} << 20};
+
+    /* The size of zlib's buffer of compressed input */
+    constexpr unsigned compressed_buffer_size{1u << 20};
+  }
+
+  /***/
+  gzip_receiver::gzip_receiver(std::filesystem::path const &path)
+  {
+    /* Open the archive here, so a missing file is reported to the caller rather than lost on the other thread */
+    gzFile file = ::gzopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+      std::string msg = std::string{"Failed to open "} + path.string() + ": " + std::strerror(errno);
+      zeus::system::throw_runtime_error("gzip_receiver", __func__, std::move(msg));
+    }
+
+    ::gzbuffer(file, compressed_buffer_size);
+    _thread = std::thread{&gzip_receiver::_inflate, this, file};
+  }
+
+  /***/
+  gzip_receiver::~gzip_receiver()
+  {
+    _stop.store(true, std::memory_order_release);
+    _thread.join();
+  }
+
+  /***/
+  void gzip_receiver::_inflate(void *handle)
+  {
+    gzFile file = static_cast<gzFile>(handle);
+
+    while (!_stop.load(std::memory_order_acquire))
+    {
+      /* Inflate straight into the ring. If the feed thread has fallen behind, wait for it to free some space. */
+      std::span<std::byte> space = _ring.prepare(chunk_size);
+      if (space.empty())
+      {
+        _mm_pause();
+        continue;
+      }
+
+      int const inflated = ::gzread(file, space.data(), static_cast<unsigned>(space.size()));
+      if (inflated > 0)
+      {
+        _ring.commit(static_cast<std::size_t>(inflated));
+        continue;
+      }
+
+      /* Either the end of the archive, or a corrupt or truncated one */
+      if (inflated < 0 || !::gzeof(file))
+      {
+        _failed.store(true, std::memory_order_release);
+      }
+      break;
+    }
+
+    ::gzclose(file);
+    _inflated.store(true, std::memory_order_release);
+  }
+}
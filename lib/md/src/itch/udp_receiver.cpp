@@ -0,0 +1,170 @@
+#include "md/itch/udp_receiver.h"
+#include "system/exception.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <netinet/in.h>
+#include <unistd.h>
+
+namespace zeus::md::itch
+{
+  namespace
+  {
+    /* Room for a single SO_TIMESTAMPNS control message */
+    constexpr std::size_t control_size{CMSG_SPACE(sizeof(timespec))};
+
+    /* Lets a read that finds the socket empty poll the device queue itself. Our reads never block, so the kernel only
+     * polls once per empty read rather than spinning for this long, in microseconds. */
+    constexpr int busy_poll_us{50};
+
+    /* Bursts at the open can be large. Ask for enough buffer to ride them out. */
+    constexpr int receive_buffer_size{16 << 20};
+
+    [[using gnu: noreturn]] void throw_socket_error(int fd, std::string const &what)
+    {
+      std::string msg = what + ": " + std::strerror(errno);
+      if (fd != -1)
+      {
+        ::close(fd);
+      }
+      zeus::system::throw_runtime_error("md::itch", "open_udp_socket", std::move(msg));
+    }
+
+    in_addr parse_address(int fd, std::string const &address)
+    {
+      in_addr parsed{};
+      if (::inet_pton(AF_INET, address.c_str(), &parsed) != 1)
+      {
+        errno = EINVAL;
+        throw_socket_error(fd, "Invalid address " + address);
+      }
+      return parsed;
+    }
+  }
+
+  /***/
+  int open_udp_socket(std::string const &group, uint16_t port, std::string const &interface, uint16_t &bound_port)
+  {
+    int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+    {
+      throw_socket_error(fd, "Failed to create socket");
+    }
+
+    /* Let the A and B lines, or several processes, share the group */
+    int const enable = 1;
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) == -1 ||
+        ::setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == -1)
+    {
+      throw_socket_error(fd, "Failed to configure socket");
+    }
+
+    /* These are tuning rather than correctness, and may need privileges we do not have, so a refusal is not an error */
+    ::setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_us, sizeof(busy_poll_us));
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer_size, sizeof(receive_buffer_size));
+
+    in_addr const group_address = parse_address(fd, group);
+    sockaddr_in bound{};
+    bound.sin_family = AF_INET;
+    bound.sin_port = htons(port);
+    bound.sin_addr = group_address;
+    if (::bind(fd, reinterpret_cast<sockaddr const *>(&bound), sizeof(bound)) == -1)
+    {
+      throw_socket_error(fd, "Failed to bind to " + group);
+    }
+
+    if (IN_MULTICAST(ntohl(group_address.s_addr)))
+    {
+      ip_mreq membership{};
+      membership.imr_multiaddr = group_address;
+      membership.imr_interface = parse_address(fd, interface);
+      if (::setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) == -1)
+      {
+        throw_socket_error(fd, "Failed to join " + group);
+      }
+    }
+
+    socklen_t length = sizeof(bound);
+    ::getsockname(fd, reinterpret_cast<sockaddr *>(&bound), &length);
+    bound_port = ntohs(bound.sin_port);
+    return fd;
+  }
+
+  /***/
+  udp_receiver::udp_receiver(std::string const &group, uint16_t port, std::string const &interface,
+                             std::size_t batch_size)
+    : _arena(batch_size * max_packet_size), _control(batch_size * control_size), _iovecs(batch_size),
+      _headers(batch_size)
+  {
+    utility::zassert_ndebug(batch_size != 0, "The batch size must be at least one.");
+    _fd = open_udp_socket(group, port, interface, _port);
+
+    /* Point each header at its own slot of the arena, once and for all */
+    for (std::size_t index = 0; index < batch_size; ++index)
+    {
+      _iovecs[index] = iovec{.iov_base = _arena.data() + index * max_packet_size, .iov_len = max_packet_size};
+      _headers[index].msg_hdr = msghdr{};
+      _headers[index].msg_hdr.msg_iov = &_iovecs[index];
+      _headers[index].msg_hdr.msg_iovlen = 1;
+      _headers[index].msg_hdr.msg_control = _control.data() + index * control_size;
+    }
+  }
+
+  /***/
+  udp_receiver::~udp_receiver()
+  {
+    ::close(_fd);
+  }
+
+  /***/
+  bool udp_receiver::_fill() noexcept
+  {
+    /* The kernel shrinks the control length to what it wrote, so it has to be reset on every call */
+    for (mmsghdr &header : _headers)
+    {
+      header.msg_hdr.msg_controllen = control_size;
+    }
+
+    int const received = ::recvmmsg(_fd, _headers.data(), static_cast<unsigned>(_headers.size()), MSG_DONTWAIT, nullptr);
+    if (received <= 0)
+    {
+      _received = _next = 0;
+      return false;
+    }
+
+    _received = static_cast<std::size_t>(received);
+    _next = 0;
+    ++_batches;
+    _packets += _received;
+    for (std::size_t index = 0; index < _received; ++index)
+    {
+      _truncated += (_headers[index].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+    }
+    return true;
+  }
+
+  /***/
+  uint64_t udp_receiver::timestamp() const noexcept
+  {
+    if (_next == 0)
+    {
+      return 0;
+    }
+
+    msghdr const &header = _headers[_next - 1].msg_hdr;
+    for (cmsghdr const *control = CMSG_FIRSTHDR(&header); control != nullptr;
+         control = CMSG_NXTHDR(const_cast<msghdr *>(&header), const_cast<cmsghdr *>(control)))
+    {
+      if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SCM_TIMESTAMPNS)
+      {
+        timespec stamp{};
+        std::memcpy(&stamp, CMSG_DATA(control), sizeof(stamp));
+        return static_cast<uint64_t>(stamp.tv_sec) * 1'000'000'000 + static_cast<uint64_t>(stamp.tv_nsec);
+      }
+    }
+
+    return 0;
+  }
+}
\ No newline at end of file
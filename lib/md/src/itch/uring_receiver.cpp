@@ -0,0 +1,190 @@
+#include "md/itch/uring_receiver.h"
+#include "md/itch/udp_receiver.h"
+#include "system/exception.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+
+namespace zeus::md::itch
+{
+  namespace
+  {
+    /* We only ever have the one recv in flight */
+    constexpr unsigned submission_entries{8};
+
+    /* The buffer group our buffers are registered under */
+    constexpr uint16_t buffer_group{0};
+
+    void *map(std::size_t size, int fd, off_t offset)
+    {
+      int const flags = fd == -1 ? MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE : MAP_SHARED | MAP_POPULATE;
+      void *mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd, offset);
+      if (mapping == MAP_FAILED)
+      {
+        std::string msg = std::string{"Failed to map ring: "} + std::strerror(errno);
+        zeus::system::throw_runtime_error("uring_receiver", "uring_receiver", std::move(msg));
+      }
+      return mapping;
+    }
+
+    template<typename T>
+    T *at(void *mapping, uint32_t offset)
+    {
+      return reinterpret_cast<T *>(static_cast<std::byte *>(mapping) + offset);
+    }
+  }
+
+  /***/
+  uring_receiver::uring_receiver(std::string const &group, uint16_t port, std::string const &interface,
+                                 std::size_t buffer_count)
+  {
+    utility::zassert_ndebug(buffer_count != 0 && buffer_count < _no_buffer && (buffer_count & (buffer_count - 1)) == 0,
+                            "The buffer count must be a power of two below 65535.");
+
+    /* Every buffer we own can be in a completion at once, so make room for all of them and the final completion of the
+     * recv. Otherwise the kernel has to park completions on its overflow list, which costs us a syscall to flush. */
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = static_cast<uint32_t>(2 * buffer_count);
+    _ring = static_cast<int>(::syscall(__NR_io_uring_setup, submission_entries, &params));
+    if (_ring == -1)
+    {
+      std::string msg = std::string{"Failed to set up io_uring: "} + std::strerror(errno);
+      zeus::system::throw_runtime_error("uring_receiver", __func__, std::move(msg));
+    }
+
+    try
+    {
+      /* Map the rings. Newer kernels share one mapping between the submission and completion rings. */
+      _sq_mapping_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+      _cq_mapping_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+      if (params.features & IORING_FEAT_SINGLE_MMAP)
+      {
+        _sq_mapping_size = _cq_mapping_size = std::max(_sq_mapping_size, _cq_mapping_size);
+      }
+
+      _sq_mapping = map(_sq_mapping_size, _ring, IORING_OFF_SQ_RING);
+      _cq_mapping = params.features & IORING_FEAT_SINGLE_MMAP ? _sq_mapping
+                                                                : map(_cq_mapping_size, _ring, IORING_OFF_CQ_RING);
+      _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+      _sqes = static_cast<io_uring_sqe *>(map(_sqes_size, _ring, IORING_OFF_SQES));
+
+      _sq_head = at<uint32_t>(_sq_mapping, params.sq_off.head);
+      _sq_tail = at<uint32_t>(_sq_mapping, params.sq_off.tail);
+      _sq_flags = at<uint32_t>(_sq_mapping, params.sq_off.flags);
+      _sq_array = at<uint32_t>(_sq_mapping, params.sq_off.array);
+      _sq_mask = *at<uint32_t>(_sq_mapping, params.sq_off.ring_mask);
+      _cq_head = at<uint32_t>(_cq_mapping, params.cq_off.head);
+      _cq_tail = at<uint32_t>(_cq_mapping, params.cq_off.tail);
+      _cqes = at<io_uring_cqe>(_cq_mapping, params.cq_off.cqes);
+      _cq_mask = *at<uint32_t>(_cq_mapping, params.cq_off.ring_mask);
+
+      /* Register the buffer ring, and fill it with every buffer */
+      _buffers_size = buffer_count * max_packet_size;
+      _buffers = static_cast<std::byte *>(map(_buffers_size, -1, 0));
+      _buffer_ring_size = buffer_count * sizeof(io_uring_buf);
+      _buffer_ring = static_cast<io_uring_buf_ring *>(map(_buffer_ring_size, -1, 0));
+      _buffer_mask = static_cast<uint16_t>(buffer_count - 1);
+
+      io_uring_buf_reg registration{};
+      registration.ring_addr = reinterpret_cast<uint64_t>(_buffer_ring);
+      registration.ring_entries = static_cast<uint32_t>(buffer_count);
+      registration.bgid = buffer_group;
+      if (::syscall(__NR_io_uring_register, _ring, IORING_REGISTER_PBUF_RING, &registration, 1) != 0)
+      {
+        std::string msg = std::string{"Failed to register buffer ring: "} + std::strerror(errno);
+        zeus::system::throw_runtime_error("uring_receiver", __func__, std::move(msg));
+      }
+
+      for (std::size_t index = 0; index < buffer_count; ++index)
+      {
+        _held = static_cast<uint16_t>(index);
+        _recycle();
+      }
+
+      _socket = open_udp_socket(group, port, interface, _port);
+      _arm();
+    }
+    catch (...)
+    {
+      _close();
+      throw;
+    }
+  }
+
+  /***/
+  uring_receiver::~uring_receiver()
+  {
+    _close();
+  }
+
+  /***/
+  void uring_receiver::_close() noexcept
+  {
+    if (_ring != -1)
+    {
+      ::close(_ring);
+    }
+    if (_socket != -1)
+    {
+      ::close(_socket);
+    }
+
+    for (auto [mapping, size] : {std::pair{static_cast<void *>(_sqes), _sqes_size},
+                                 std::pair{static_cast<void *>(_buffers), _buffers_size},
+                                 std::pair{static_cast<void *>(_buffer_ring), _buffer_ring_size},
+                                 std::pair{_cq_mapping != _sq_mapping ? _cq_mapping : nullptr, _cq_mapping_size},
+                                 std::pair{_sq_mapping, _sq_mapping_size}})
+    {
+      if (mapping != nullptr)
+      {
+        ::munmap(mapping, size);
+      }
+    }
+
+    _ring = _socket = -1;
+    _sqes = nullptr;
+    _buffers = nullptr;
+    _buffer_ring = nullptr;
+    _sq_mapping = _cq_mapping = nullptr;
+  }
+
+  /***/
+  void uring_receiver::_arm() noexcept
+  {
+    /* A submission the kernel refused last time is still queued, so submit that again rather than queue another. Only
+     * ever having the one entry in the ring means we can never end up with two recvs armed. */
+    uint32_t tail = *_sq_tail;
+    if (tail == std::atomic_ref<uint32_t>{*_sq_head}.load(std::memory_order_acquire))
+    {
+      uint32_t const index = tail & _sq_mask;
+
+      io_uring_sqe &submission = _sqes[index];
+      std::memset(&submission, 0, sizeof(submission));
+      submission.opcode = IORING_OP_RECV;
+      submission.fd = _socket;
+      submission.ioprio = IORING_RECV_MULTISHOT;
+      submission.flags = IOSQE_BUFFER_SELECT;
+      submission.buf_group = buffer_group;
+
+      _sq_array[index] = index;
+      std::atomic_ref<uint32_t>{*_sq_tail}.store(++tail, std::memory_order_release);
+    }
+
+    /* If the submission is refused, it stays queued and we try again on the next poll */
+    uint32_t const pending = tail - std::atomic_ref<uint32_t>{*_sq_head}.load(std::memory_order_acquire);
+    _armed = ::syscall(__NR_io_uring_enter, _ring, pending, 0, 0, nullptr, 0) == static_cast<long>(pending);
+    _submissions += _armed;
+  }
+
+  /***/
+  void uring_receiver::_flush_overflow() noexcept
+  {
+    ::syscall(__NR_io_uring_enter, _ring, 0, 0, IORING_ENTER_GETEVENTS, nullptr, 0);
+  }
+}
\ No newline at end of file
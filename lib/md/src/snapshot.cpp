@@ -0,0 +1,103 @@
+#include "md/snapshot.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace zeus::md
+{
+  /***/
+  void snapshot_writer::save(std::filesystem::path const &path) const
+  {
+    std::filesystem::path staging = path;
+    staging += ".partial";
+
+    int fd = ::open(staging.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1)
+    {
+      std::string msg = std::string{"Failed to open "} + staging.string() + ": " + std::strerror(errno);
+      zeus::system::throw_runtime_error("snapshot_writer", __func__, std::move(msg));
+    }
+
+    for (std::size_t written = 0; written < _image.size();)
+    {
+      ssize_t const count = ::write(fd, _image.data() + written, _image.size() - written);
+      if (count == -1)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+
+        std::string msg = std::string{"Failed to write snapshot: "} + std::strerror(errno);
+        ::close(fd);
+        zeus::system::throw_runtime_error("snapshot_writer", __func__, std::move(msg));
+      }
+      written += static_cast<std::size_t>(count);
+    }
+
+    if (::fsync(fd) == -1 || ::close(fd) == -1)
+    {
+      std::string msg = std::string{"Failed to flush snapshot: "} + std::strerror(errno);
+      zeus::system::throw_runtime_error("snapshot_writer", __func__, std::move(msg));
+    }
+
+    if (::rename(staging.c_str(), path.c_str()) == -1)
+    {
+      std::string msg = std::string{"Failed to rename snapshot into place: "} + std::strerror(errno);
+      zeus::system::throw_runtime_error("snapshot_writer", __func__, std::move(msg));
+    }
+  }
+
+  /***/
+  snapshot_reader::snapshot_reader(std::filesystem::path const &path)
+  {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+      std::string msg = std::string{"Failed to open "} + path.string() + ": " + std::strerror(errno);
+      zeus::system::throw_runtime_error("snapshot_reader", __func__, std::move(msg));
+    }
+
+    struct stat status{};
+    if (::fstat(fd, &status) == -1)
+    {
+      std::string msg = std::string{"Failed to stat file: "} + std::strerror(errno);
+      ::close(fd);
+      zeus::system::throw_runtime_error("snapshot_reader", __func__, std::move(msg));
+    }
+
+    /* mmap rejects an empty mapping. An empty snapshot fails validation like any other short one. */
+    auto const size = static_cast<std::size_t>(status.st_size);
+    if (size != 0)
+    {
+      /* We are about to read all of it, so fault it in up front */
+      _mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+      if (_mapping == MAP_FAILED)
+      {
+        _mapping = nullptr;
+        std::string msg = std::string{"Failed to map file: "} + std::strerror(errno);
+        ::close(fd);
+        zeus::system::throw_runtime_error("snapshot_reader", __func__, std::move(msg));
+      }
+
+      _image = {static_cast<std::byte const *>(_mapping), size};
+    }
+
+    /* The mapping keeps its own reference to the file */
+    ::close(fd);
+  }
+
+  /***/
+  snapshot_reader::~snapshot_reader()
+  {
+    if (_mapping != nullptr)
+    {
+      ::munmap(_mapping, _image.size());
+    }
+  }
+}
\ No newline at end of file
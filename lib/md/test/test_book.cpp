@@ -1,5 +1,12 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
 #include "md/book.h"
+#include "md/snapshot.h"
 
 using namespace zeus;
 
@@ -422,4 +429,494 @@ TEST(MD_BOOK, partial_then_remove)
     EXPECT_EQ(price, core::price_t{1});
     EXPECT_EQ(quantity, core::quantity_t{100});
   }
+}
+
+TEST(MD_BOOK, queue_position)
+{
+  core::price_t tick_size{1};
+  md::book book{tick_size};
+
+  for (core::ordid_t id = 1; id <= 4; ++id)
+  {
+    md::order_add order_buy{
+      ._order_id = id,
+      ._quantity = core::quantity_t{100} * static_cast<core::quantity_t>(id),
+      ._price = core::price_t{2},
+      ._side = core::order_side::BUY
+    };
+    book.add(order_buy);
+  }
+
+  /* Orders are queued in time priority */
+  {
+    auto const& [orders, quantity] = book.queue_position(3);
+    EXPECT_EQ(orders, 2);
+    EXPECT_EQ(quantity, core::quantity_t{300});
+  }
+
+  /* Fill the front of the queue. It leaves the level, and everyone moves up. */
+  md::order_executed order_execute{
+    ._order_id = 1,
+    ._shares_executed = 100
+  };
+  book.execute(order_execute);
+
+  {
+    auto const& [orders, quantity] = book.queue_position(3);
+    EXPECT_EQ(orders, 1);
+    EXPECT_EQ(quantity, core::quantity_t{200});
+  }
+
+  /* A partial cancel keeps the order's place in the queue */
+  md::order_canceled order_cancel{
+    ._order_id = 2,
+    ._shares_cancelled = 150
+  };
+  book.cancel(order_cancel);
+
+  {
+    auto const& [orders, quantity] = book.queue_position(3);
+    EXPECT_EQ(orders, 1);
+    EXPECT_EQ(quantity, core::quantity_t{50});
+  }
+
+  /* Remove from the middle of the queue */
+  md::order_removed order_remove{
+    ._order_id = 3
+  };
+  book.remove(order_remove);
+
+  {
+    auto const& [orders, quantity] = book.queue_position(4);
+    EXPECT_EQ(orders, 1);
+    EXPECT_EQ(quantity, core::quantity_t{50});
+  }
+
+  {
+    auto const& [price, quantity] = book.best_bid();
+    EXPECT_EQ(price, core::price_t{2});
+    EXPECT_EQ(quantity, core::quantity_t{450});
+  }
+}
+
+TEST(MD_BOOK, live_and_peak_orders)
+{
+  core::price_t tick_size{1};
+  md::book book{tick_size, 4};
+
+  /* Churn far more orders through the book than it was sized for, while only a few rest at any time */
+  for (core::ordid_t id = 1; id <= 10000; ++id)
+  {
+    md::order_add order_buy{
+      ._order_id = id,
+      ._quantity = core::quantity_t{100},
+      ._price = core::price_t{2},
+      ._side = core::order_side::BUY
+    };
+    book.add(order_buy);
+
+    if (id <= 2)
+    {
+      continue;
+    }
+
+    /* Alternate between a full fill, a delete and a replace, each of which releases the old order */
+    core::ordid_t const previous = id - 2;
+    switch (id % 3)
+    {
+      case 0:
+        book.execute(md::order_executed{._order_id = previous, ._shares_executed = 100});
+        break;
+      case 1:
+        book.remove(md::order_removed{._order_id = previous});
+        break;
+      default:
+        book.replace(md::order_replaced{
+          ._original_order_id = previous,
+          ._new_order_id = previous + 1000000,
+          ._quantity = 100,
+          ._price = core::price_t{2}
+        });
+        book.remove(md::order_removed{._order_id = previous + 1000000});
+        break;
+    }
+  }
+
+  EXPECT_EQ(book.live_orders(), 2);
+  EXPECT_EQ(book.peak_orders(), 4);
+
+  {
+    auto const& [price, quantity] = book.best_bid();
+    EXPECT_EQ(price, core::price_t{2});
+    EXPECT_EQ(quantity, core::quantity_t{200});
+  }
+}
+
+TEST(MD_BOOK, wide_book)
+{
+  core::price_t tick_size{1};
+  md::book book{tick_size, 16, 8};
+
+  /* Far more than a window apart, so these would alias in a fixed ring */
+  for (core::ordid_t id = 1; id <= 5; ++id)
+  {
+    md::order_add order_buy{
+      ._order_id = id,
+      ._quantity = core::quantity_t{10} * static_cast<core::quantity_t>(id),
+      ._price = core::price_t{1000 - 100 * static_cast<int64_t>(id)},
+      ._side = core::order_side::BUY
+    };
+    book.add(order_buy);
+
+    md::order_add order_sell{
+      ._order_id = 100 + id,
+      ._quantity = core::quantity_t{10} * static_cast<core::quantity_t>(id),
+      ._price = core::price_t{1000 + 100 * static_cast<int64_t>(id)},
+      ._side = core::order_side::SELL
+    };
+    book.add(order_sell);
+  }
+
+  /* A new touch far away from the window drags it along */
+  md::order_add order_buy_touch{
+    ._order_id = 6,
+    ._quantity = core::quantity_t{5},
+    ._price = core::price_t{990},
+    ._side = core::order_side::BUY
+  };
+  book.add(order_buy_touch);
+
+  {
+    auto const& [price, quantity] = book.best_bid();
+    EXPECT_EQ(price, core::price_t{990});
+    EXPECT_EQ(quantity, core::quantity_t{5});
+  }
+
+  /* Walk each side down through the spilled levels */
+  book.remove(md::order_removed{._order_id = 6});
+  for (core::ordid_t id = 1; id <= 5; ++id)
+  {
+    {
+      auto const& [price, quantity] = book.best_bid();
+      EXPECT_EQ(price, core::price_t{1000 - 100 * static_cast<int64_t>(id)});
+      EXPECT_EQ(quantity, core::quantity_t{10} * static_cast<core::quantity_t>(id));
+    }
+
+    {
+      auto const& [price, quantity] = book.best_ask();
+      EXPECT_EQ(price, core::price_t{1000 + 100 * static_cast<int64_t>(id)});
+      EXPECT_EQ(quantity, core::quantity_t{10} * static_cast<core::quantity_t>(id));
+    }
+
+    book.remove(md::order_removed{._order_id = id});
+    book.execute(md::order_executed{._order_id = 100 + id, ._shares_executed = 10 * static_cast<core::quantity_t>(id)});
+  }
+
+  EXPECT_EQ(book.best_bid().second, core::quantity_t{0});
+  EXPECT_EQ(book.best_ask().second, core::quantity_t{0});
+  EXPECT_EQ(book.live_orders(), 0);
+}
+
+TEST(MD_BOOK, spilled_level_updates)
+{
+  core::price_t tick_size{1};
+  md::book book{tick_size, 16, 8};
+
+  md::order_add order_buy{
+    ._order_id = 1,
+    ._quantity = core::quantity_t{100},
+    ._price = core::price_t{500},
+    ._side = core::order_side::BUY
+  };
+  book.add(order_buy);
+
+  /* Two orders resting well outside the window, in the same level */
+  for (core::ordid_t id = 2; id <= 3; ++id)
+  {
+    md::order_add order_deep{
+      ._order_id = id,
+      ._quantity = core::quantity_t{100},
+      ._price = core::price_t{400},
+      ._side = core::order_side::BUY
+    };
+    book.add(order_deep);
+  }
+
+  /* Update them while they are spilled */
+  book.cancel(md::order_canceled{._order_id = 2, ._shares_cancelled = 40});
+  book.execute(md::order_executed{._order_id = 3, ._shares_executed = 30});
+  EXPECT_EQ(book.queue_position(3).second, core::quantity_t{60});
+
+  /* Once the touch is gone, they become the touch */
+  book.remove(md::order_removed{._order_id = 1});
+  {
+    auto const& [price, quantity] = book.best_bid();
+    EXPECT_EQ(price, core::price_t{400});
+    EXPECT_EQ(quantity, core::quantity_t{130});
+  }
+}
+
+TEST(MD_BOOK, tick_table)
+{
+  md::tick_table ticks{
+    {._from = core::price_t{0}, ._tick_size = core::price_t{0.0001}},
+    {._from = core::price_t{1}, ._tick_size = core::price_t{0.01}}
+  };
+  md::book book{ticks};
+
+  /* A sub-dollar bid a tick below a dollar ask */
+  md::order_add order_buy{
+    ._order_id = 1,
+    ._quantity = core::quantity_t{100},
+    ._price = core::price_t{0.9999},
+    ._side = core::order_side::BUY
+  };
+  book.add(order_buy);
+
+  md::order_add order_sell{
+    ._order_id = 2,
+    ._quantity = core::quantity_t{100},
+    ._price = core::price_t{1},
+    ._side = core::order_side::SELL
+  };
+  book.add(order_sell);
+
+  md::order_add order_sell_behind{
+    ._order_id = 3,
+    ._quantity = core::quantity_t{200},
+    ._price = core::price_t{1.01},
+    ._side = core::order_side::SELL
+  };
+  book.add(order_sell_behind);
+
+  {
+    auto const& [price, quantity] = book.best_bid();
+    EXPECT_EQ(price, core::price_t{0.9999});
+    EXPECT_EQ(quantity, core::quantity_t{100});
+  }
+
+  {
+    auto const& [price, quantity] = book.best_ask();
+    EXPECT_EQ(price, core::price_t{1});
+    EXPECT_EQ(quantity, core::quantity_t{100});
+  }
+
+  /* The next level up is a whole cent away, but only one tick on the ladder */
+  book.remove(md::order_removed{._order_id = 2});
+  {
+    auto const& [price, quantity] = book.best_ask();
+    EXPECT_EQ(price, core::price_t{1.01});
+    EXPECT_EQ(quantity, core::quantity_t{200});
+  }
+}
+
+TEST(MD_BOOK, top_of_book_changes)
+{
+  core::price_t tick_size{1};
+  md::book book{tick_size};
+
+  auto add = [&book](core::ordid_t order_id, int64_t price, core::order_side side)
+  {
+    return book.add(md::order_add{
+      ._order_id = order_id,
+      ._quantity = core::quantity_t{100},
+      ._price = core::price_t{price},
+      ._side = side
+    });
+  };
+
+  /* New best prices, and more quantity at the best price, change the top of book */
+  EXPECT_TRUE(add(1, 10, core::order_side::BUY));
+  EXPECT_TRUE(add(2, 10, core::order_side::BUY));
+  EXPECT_TRUE(add(3, 12, core::order_side::SELL));
+
+  /* Anything behind the touch does not */
+  EXPECT_FALSE(add(4, 9, core::order_side::BUY));
+  EXPECT_FALSE(add(5, 13, core::order_side::SELL));
+  EXPECT_FALSE(book.cancel(md::order_canceled{._order_id = 4, ._shares_cancelled = core::quantity_t{50}}));
+  EXPECT_FALSE(book.remove(md::order_removed{._order_id = 5}));
+
+  /* Trading at the touch does */
+  EXPECT_TRUE(book.execute(md::order_executed{._order_id = 3, ._shares_executed = core::quantity_t{50}}));
+  EXPECT_TRUE(book.cancel(md::order_canceled{._order_id = 1, ._shares_cancelled = core::quantity_t{100}}));
+  EXPECT_TRUE(book.remove(md::order_removed{._order_id = 2}));
+
+  /* A replace changes the top of book if either leg touches it. Order 4 is now the best bid. */
+  EXPECT_FALSE(add(6, 7, core::order_side::BUY));
+  EXPECT_FALSE(book.replace(md::order_replaced{
+    ._original_order_id = 6,
+    ._new_order_id = 7,
+    ._quantity = core::quantity_t{100},
+    ._price = core::price_t{6}
+  }));
+  EXPECT_TRUE(book.replace(md::order_replaced{
+    ._original_order_id = 4,
+    ._new_order_id = 8,
+    ._quantity = core::quantity_t{100},
+    ._price = core::price_t{5}
+  }));
+
+  auto const& [price, quantity] = book.best_bid();
+  EXPECT_EQ(price, core::price_t{6});
+  EXPECT_EQ(quantity, core::quantity_t{100});
+}
+
+TEST(MD_BOOK, depth)
+{
+  core::price_t tick_size{1};
+  md::book book{tick_size, 16, 8};
+
+  using level_t = std::pair<core::price_t, core::quantity_t>;
+  std::array<level_t, 8> levels{};
+  EXPECT_EQ(book.depth(core::order_side::BUY, 5, levels), 0);
+  EXPECT_EQ(book.depth(core::order_side::SELL, 5, levels), 0);
+
+  /* Two bids in the window with a gap between them, and one far enough away to spill. Two orders share the touch. */
+  std::array<std::pair<int64_t, core::quantity_t>, 4> const bids{{{100, 10}, {100, 20}, {97, 30}, {50, 40}}};
+  core::ordid_t id{1};
+  for (auto const &[price, quantity] : bids)
+  {
+    book.add(md::order_add{._order_id = id++, ._quantity = quantity, ._price = core::price_t{price},
+                           ._side = core::order_side::BUY});
+  }
+
+  std::array<int64_t, 3> const asks{101, 104, 200};
+  for (int64_t price : asks)
+  {
+    book.add(md::order_add{._order_id = id++, ._quantity = core::quantity_t{5}, ._price = core::price_t{price},
+                           ._side = core::order_side::SELL});
+  }
+
+  ASSERT_EQ(book.depth(core::order_side::BUY, 5, levels), 3);
+  EXPECT_EQ(levels[0], (level_t{core::price_t{100}, 30}));
+  EXPECT_EQ(levels[1], (level_t{core::price_t{97}, 30}));
+  EXPECT_EQ(levels[2], (level_t{core::price_t{50}, 40}));
+
+  ASSERT_EQ(book.depth(core::order_side::SELL, 5, levels), 3);
+  EXPECT_EQ(levels[0], (level_t{core::price_t{101}, 5}));
+  EXPECT_EQ(levels[1], (level_t{core::price_t{104}, 5}));
+  EXPECT_EQ(levels[2], (level_t{core::price_t{200}, 5}));
+
+  /* Limited by the number of levels asked for, and by the size of the buffer */
+  EXPECT_EQ(book.depth(core::order_side::BUY, 2, levels), 2);
+  EXPECT_EQ(book.depth(core::order_side::BUY, 5, std::span{levels}.first(1)), 1);
+  EXPECT_EQ(levels[0], (level_t{core::price_t{100}, 30}));
+}
+
+TEST(MD_BOOK, level_updates)
+{
+  core::price_t tick_size{1};
+  md::book book{tick_size};
+  md::level_update_ring ring;
+
+  /* Nothing is streamed until asked for */
+  book.add(md::order_add{._order_id = 1, ._quantity = 100, ._price = core::price_t{10}, ._side = core::order_side::BUY});
+  EXPECT_TRUE(ring.empty());
+
+  book.stream_to(&ring, 7);
+  book.add(md::order_add{._order_id = 2, ._quantity = 50, ._price = core::price_t{10}, ._side = core::order_side::BUY});
+  book.add(md::order_add{._order_id = 3, ._quantity = 20, ._price = core::price_t{11}, ._side = core::order_side::SELL});
+  book.cancel(md::order_canceled{._order_id = 1, ._shares_cancelled = 30});
+  book.execute(md::order_executed{._order_id = 3, ._shares_executed = 20});
+  book.remove(md::order_removed{._order_id = 2});
+
+  struct expected
+  {
+    core::order_side _side;
+    int64_t _price;
+    core::quantity_t _quantity;
+  };
+  std::array<expected, 5> const updates{{
+    {core::order_side::BUY, 10, 150},
+    {core::order_side::SELL, 11, 20},
+    {core::order_side::BUY, 10, 120},
+    {core::order_side::SELL, 11, 0},
+    {core::order_side::BUY, 10, 70}
+  }};
+
+  ASSERT_EQ(ring.size(), updates.size());
+  for (std::size_t i = 0; i < updates.size(); ++i)
+  {
+    md::level_update_ring::handle handle = ring.read();
+    auto const &update = static_cast<md::level_update const &>(handle);
+    EXPECT_EQ(update._sequence, i + 1);
+    EXPECT_EQ(update._instrument, 7);
+    EXPECT_EQ(update._side, updates[i]._side);
+    EXPECT_EQ(update._price, core::price_t{updates[i]._price});
+    EXPECT_EQ(update._quantity, updates[i]._quantity);
+  }
+
+  /* And nothing once we stop */
+  book.stream_to(nullptr);
+  book.remove(md::order_removed{._order_id = 1});
+  EXPECT_TRUE(ring.empty());
+}
+
+TEST(MD_BOOK, order_info_packing)
+{
+  static_assert(sizeof(md::order_map<md::order_info>::slot) == 16);
+
+  md::order_info const sell{md::order_info::max_ticks, core::order_side::SELL, 42};
+  EXPECT_EQ(sell.ticks(), md::order_info::max_ticks);
+  EXPECT_EQ(sell.side(), core::order_side::SELL);
+  EXPECT_EQ(sell._node, 42);
+
+  md::order_info const buy{12345, core::order_side::BUY, 7};
+  EXPECT_EQ(buy.ticks(), 12345);
+  EXPECT_EQ(buy.side(), core::order_side::BUY);
+}
+
+TEST(MD_BOOK, snapshot_rejects_tampering)
+{
+  core::price_t tick_size{1};
+  md::book book{tick_size};
+
+  /* An order ID that cannot be mistaken for anything else in the image */
+  constexpr core::ordid_t id{0x0123456789ABCDEF};
+  for (core::ordid_t order_id : {id, id + 1})
+  {
+    md::order_add order_buy{
+      ._order_id = order_id,
+      ._quantity = core::quantity_t{100},
+      ._price = core::price_t{2},
+      ._side = core::order_side::BUY
+    };
+    book.add(order_buy);
+  }
+
+  md::snapshot_writer writer;
+  uint64_t const offset = book.save(writer);
+  std::vector<std::byte> const image(writer.bytes().begin(), writer.bytes().end());
+  EXPECT_NO_THROW((md::book{md::snapshot_reader{image}, offset}));
+
+  /* Each order is saved first in the pool, then again in the order map */
+  auto const find = [&image](core::ordid_t order_id, std::size_t from) {
+    auto const *key = reinterpret_cast<std::byte const *>(&order_id);
+    auto const found = std::search(image.begin() + static_cast<std::ptrdiff_t>(from), image.end(), key, key + sizeof(order_id));
+    return static_cast<std::size_t>(found - image.begin());
+  };
+  std::size_t const node = find(id, 0);
+  std::size_t const slot = find(id, node + 1);
+  std::size_t const other_slot = find(id + 1, find(id + 1, 0) + 1);
+  ASSERT_LT(slot, image.size());
+  ASSERT_LT(other_slot, image.size());
+
+  using slot_t = md::order_map<md::order_info>::slot;
+  slot_t other{};
+  std::memcpy(&other, image.data() + other_slot, sizeof(other));
+
+  auto const rejects = [&](std::size_t at, auto value) {
+    std::vector<std::byte> tampered = image;
+    std::memcpy(tampered.data() + at, &value, sizeof(value));
+    EXPECT_THROW((md::book{md::snapshot_reader{tampered}, offset}), std::runtime_error);
+  };
+
+  /* A queue running off the end of the pool, a queue that loops back on itself, and a map entry for another order */
+  rejects(node + offsetof(md::order_node, _next), md::order_handle_t{7});
+  rejects(node + offsetof(md::order_node, _next), md::order_handle_t{0});
+  rejects(slot, id + 2);
+
+  /* A map entry for a level the order is not in, and a duplicate entry that leaves the first order without one */
+  rejects(slot + offsetof(slot_t, _value), uint32_t{3 << 1});
+  rejects(slot, other);
 }
\ No newline at end of file
@@ -0,0 +1,772 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <zlib.h>
+
+#include "md/itch/feed.h"
+#include "md/itch/file_receiver.h"
+#include "md/itch/gzip_receiver.h"
+
+using namespace zeus;
+using namespace zeus::md::itch;
+
+namespace
+{
+  /* Queues up messages in memory in the BinaryFILE framing */
+  class message_buffer
+  {
+  public:
+    template<typename T>
+    void push(T const &message)
+    {
+      _buffer.push_back(static_cast<std::byte>(sizeof(T) >> 8));
+      _buffer.push_back(static_cast<std::byte>(sizeof(T) & 0xFF));
+
+      auto const *bytes = reinterpret_cast<std::byte const *>(&message);
+      _buffer.insert(_buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    std::span<std::byte const> bytes() const { return _buffer; }
+
+    std::unique_ptr<buffer_receiver> receiver() const
+    {
+      return std::make_unique<buffer_receiver>(std::span<std::byte const>{_buffer});
+    }
+
+  private:
+    std::vector<std::byte> _buffer;
+  };
+
+  stock_directory_message make_directory(uint16_t locate, std::string_view name = "ZEUS")
+  {
+    stock_directory_message message{};
+    message._header._type = message_type::STOCK_DIRECTORY_MESSAGE;
+    message._header._stock_locate = locate;
+    std::fill(std::begin(message._stock), std::end(message._stock), ' ');
+    std::copy(name.begin(), name.end(), message._stock);
+    return message;
+  }
+
+  add_order_no_mpid_message make_add(uint16_t locate, uint64_t order_id, uint8_t side, uint32_t shares, int32_t price,
+                                     uint32_t timestamp = 0)
+  {
+    add_order_no_mpid_message message{};
+    message._header._type = message_type::ADD_ORDER_NO_MPID_MESSAGE;
+    message._header._stock_locate = locate;
+    message._header._timestamp.lower = timestamp;
+    message._order_reference_number = order_id;
+    message._buy_sell_indicator = side;
+    message._shares = shares;
+    message._price = price;
+    return message;
+  }
+}
+
+TEST(MD_ITCH_FEED, lazy_books)
+{
+  message_buffer messages;
+  messages.push(make_directory(7));
+  messages.push(make_add(42, 1, 'B', 100, 100000));
+  messages.push(make_add(7, 2, 'S', 200, 101000));
+
+  feed<buffer_receiver> itch{messages.receiver()};
+  EXPECT_EQ(itch.active_books(), 0);
+  EXPECT_EQ(itch.book(7), nullptr);
+
+  /* The stock directory activates a book */
+  EXPECT_FALSE(itch.poll());
+  EXPECT_EQ(itch.active_books(), 1);
+  ASSERT_NE(itch.book(7), nullptr);
+
+  /* So does the first add for a locate we have not seen */
+  EXPECT_TRUE(itch.poll());
+  EXPECT_EQ(itch.active_books(), 2);
+  ASSERT_NE(itch.book(42), nullptr);
+  {
+    auto const& [price, quantity] = itch.book(42)->best_bid();
+    EXPECT_EQ(price, core::price_t{10});
+    EXPECT_EQ(quantity, core::quantity_t{100});
+  }
+
+  /* An add for an active locate reuses its book */
+  EXPECT_TRUE(itch.poll());
+  EXPECT_EQ(itch.active_books(), 2);
+  {
+    auto const& [price, quantity] = itch.book(7)->best_ask();
+    EXPECT_EQ(price, core::price_t{10.1});
+    EXPECT_EQ(quantity, core::quantity_t{200});
+  }
+  EXPECT_EQ(itch.book(1), nullptr);
+
+  /* Nothing left to read */
+  EXPECT_FALSE(itch.poll());
+}
+
+TEST(MD_ITCH_FEED, updates_do_not_build_books)
+{
+  message_buffer messages;
+  order_delete_message remove{};
+  remove._header._type = message_type::ORDER_DELETE_MESSAGE;
+  remove._header._stock_locate = 9;
+  remove._order_reference_number = 1;
+  messages.push(remove);
+
+  /* Enough locates to fill more than one chunk of the arena */
+  for (uint16_t locate = 1; locate <= 200; ++locate)
+  {
+    messages.push(make_add(locate, locate, 'B', 100, 100000));
+  }
+
+  feed<buffer_receiver> itch{messages.receiver()};
+
+  /* An update for a locate that has never had an order cannot be about anything we know of */
+  EXPECT_FALSE(itch.poll());
+  EXPECT_EQ(itch.active_books(), 0);
+  EXPECT_EQ(itch.unknown_messages(), 1);
+
+  /* Books stay where they are as the arena grows */
+  EXPECT_TRUE(itch.poll());
+  md::book const *first = itch.book(1);
+  itch.drain();
+  EXPECT_EQ(itch.active_books(), 200);
+  EXPECT_EQ(itch.book(1), first);
+  EXPECT_EQ(itch.book(200)->best_bid().second, 100);
+}
+
+TEST(MD_ITCH_FEED, buffer_receiver)
+{
+  message_buffer messages;
+  messages.push(make_directory(1));
+  messages.push(make_add(1, 1, 'B', 100, 100000));
+
+  auto receiver = messages.receiver();
+  std::span<std::byte const> directory = receiver->next();
+  EXPECT_EQ(directory.size(), sizeof(stock_directory_message));
+  EXPECT_EQ(static_cast<message_type>(directory[0]), message_type::STOCK_DIRECTORY_MESSAGE);
+
+  std::span<std::byte const> add = receiver->next();
+  EXPECT_EQ(add.size(), sizeof(add_order_no_mpid_message));
+  EXPECT_EQ(static_cast<message_type>(add[0]), message_type::ADD_ORDER_NO_MPID_MESSAGE);
+
+  EXPECT_TRUE(receiver->next().empty());
+  EXPECT_EQ(receiver->remaining(), 0);
+}
+
+TEST(MD_ITCH_FEED, big_endian_fields)
+{
+  /* An add order exactly as it appears on the wire */
+  std::vector<uint8_t> const wire{
+    'A',
+    0x00, 0x07,                                     /* Stock locate */
+    0x00, 0x00,                                     /* Tracking number */
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05,             /* Timestamp */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, /* Order reference number */
+    'S',
+    0x00, 0x00, 0x01, 0x2C,                         /* Shares */
+    'Z', 'E', 'U', 'S', ' ', ' ', ' ', ' ',
+    0x00, 0x01, 0x8A, 0x88                          /* Price */
+  };
+  ASSERT_EQ(wire.size(), sizeof(add_order_no_mpid_message));
+
+  auto const &message = *reinterpret_cast<add_order_no_mpid_message const *>(wire.data());
+  EXPECT_EQ(message._header._stock_locate, 7);
+  EXPECT_EQ(static_cast<uint64_t>(message._header._timestamp), 0x000102030405);
+  EXPECT_EQ(message._order_reference_number, 0x0102);
+  EXPECT_EQ(message._shares, 300);
+  EXPECT_EQ(message._price, 101000);
+}
+
+TEST(MD_ITCH_FEED, file_receiver)
+{
+  message_buffer messages;
+  messages.push(make_directory(1));
+  for (uint32_t id = 1; id <= 4; ++id)
+  {
+    messages.push(make_add(1, id, 'B', 100, 100000 + id * 100, id * 1000));
+  }
+
+  std::filesystem::path const path = std::filesystem::temp_directory_path() / "zeus_test_itch_replay.bin";
+  {
+    std::ofstream file{path, std::ios::binary};
+    file.write(reinterpret_cast<char const *>(messages.bytes().data()),
+               static_cast<std::streamsize>(messages.bytes().size()));
+  }
+
+  /* Replay the whole file */
+  {
+    feed<file_receiver> itch{std::make_unique<file_receiver>(path)};
+    EXPECT_FALSE(itch.poll());
+    while (itch.poll());
+
+    auto const& [price, quantity] = itch.book(1)->best_bid();
+    EXPECT_EQ(price, core::price_t::from_underlying(1004000000));
+    EXPECT_EQ(quantity, core::quantity_t{100});
+  }
+
+  /* Stop after a number of messages */
+  {
+    file_receiver receiver{path, 3};
+    EXPECT_EQ(receiver.size(), messages.bytes().size());
+    while (!receiver.next().empty());
+    EXPECT_EQ(receiver.delivered(), 3);
+  }
+
+  /* Stop once the feed passes a timestamp */
+  {
+    file_receiver receiver{path, file_receiver::all_messages, 2500};
+    while (!receiver.next().empty());
+    EXPECT_EQ(receiver.delivered(), 3);
+    EXPECT_TRUE(receiver.next().empty());
+  }
+
+  std::filesystem::remove(path);
+}
+
+TEST(MD_ITCH_FEED, gzip_receiver)
+{
+  /* Enough messages to wrap around the ring a couple of times */
+  constexpr uint64_t num_messages{1'000'000};
+
+  std::filesystem::path const path = std::filesystem::temp_directory_path() / "zeus_test_itch_replay.bin.gz";
+  {
+    gzFile file = ::gzopen(path.c_str(), "wb1");
+    ASSERT_NE(file, nullptr);
+    for (uint64_t id = 1; id <= num_messages; id += 10'000)
+    {
+      message_buffer messages;
+      for (uint64_t offset = 0; offset < 10'000; ++offset)
+      {
+        messages.push(make_add(1, id + offset, 'B', 100, 100000));
+      }
+      ::gzwrite(file, messages.bytes().data(), static_cast<unsigned>(messages.bytes().size()));
+    }
+    ::gzclose(file);
+  }
+
+  gzip_receiver receiver{path};
+  uint64_t expected_id{1};
+  while (!receiver.finished())
+  {
+    std::span<std::byte const> message = receiver.next();
+    if (message.empty())
+    {
+      continue;
+    }
+
+    ASSERT_EQ(message.size(), sizeof(add_order_no_mpid_message));
+    auto const &add = *reinterpret_cast<add_order_no_mpid_message const *>(message.data());
+    ASSERT_EQ(add._order_reference_number, expected_id);
+    ++expected_id;
+  }
+
+  EXPECT_EQ(expected_id, num_messages + 1);
+  EXPECT_FALSE(receiver.failed());
+  EXPECT_TRUE(receiver.next().empty());
+
+  std::filesystem::remove(path);
+}
+
+TEST(MD_ITCH_FEED, poll_n)
+{
+  message_buffer messages;
+  messages.push(make_directory(1));
+  messages.push(make_directory(2));
+  messages.push(make_add(1, 1, 'B', 100, 100000));
+  messages.push(make_add(1, 2, 'B', 100, 99000));
+  messages.push(make_add(2, 3, 'S', 100, 101000));
+  messages.push(make_add(1, 4, 'B', 50, 100000));
+
+  feed<buffer_receiver> itch{messages.receiver()};
+
+  /* Only the first add touches the top of book */
+  std::span<uint16_t const> changed = itch.poll_n(3);
+  EXPECT_EQ(std::vector<uint16_t>(changed.begin(), changed.end()), (std::vector<uint16_t>{1}));
+
+  /* The add behind the touch is ignored, and each book is reported once, in the order it first changed */
+  changed = itch.drain();
+  EXPECT_EQ(std::vector<uint16_t>(changed.begin(), changed.end()), (std::vector<uint16_t>{2, 1}));
+
+  EXPECT_TRUE(itch.drain().empty());
+}
+
+TEST(MD_ITCH_FEED, skips_unknown_and_malformed_messages)
+{
+  message_buffer messages;
+
+  /* A type we do not know about, framed like any other message */
+  retail_price_improvement_indicator_message retail{};
+  retail._header._type = static_cast<message_type>('N');
+  retail._header._stock_locate = 1;
+  messages.push(retail);
+
+  /* A known type that is too short to hold its fields */
+  messages.push(make_directory(1)._header);
+
+  /* A message we understand but do not act on */
+  trade_message trade{};
+  trade._header._type = message_type::TRADE_MESSAGE;
+  trade._header._stock_locate = 1;
+  messages.push(trade);
+
+  messages.push(make_add(1, 1, 'B', 100, 100000));
+
+  feed<buffer_receiver> itch{messages.receiver()};
+  std::span<uint16_t const> changed = itch.drain();
+  EXPECT_EQ(std::vector<uint16_t>(changed.begin(), changed.end()), (std::vector<uint16_t>{1}));
+  EXPECT_EQ(itch.active_books(), 1);
+}
+
+namespace
+{
+  /* Counts the events it hears about, and ignores imbalances and halts */
+  struct recording_listener
+  {
+    void on_book_update(uint16_t locate, md::book const &book)
+    {
+      _updates.push_back(locate);
+      _best_bid = book.best_bid().first;
+    }
+
+    void on_trade(trade_message const &message) { _traded += message._shares; }
+    void on_cross(cross_trade_message const &message) { _crossed += message._shares; }
+    void on_execution(order_executed_message const &message) { _executed += message._executed_shares; }
+
+    std::vector<uint16_t> _updates;
+    core::price_t _best_bid{core::invalid_price};
+    uint64_t _traded{0};
+    uint64_t _crossed{0};
+    uint64_t _executed{0};
+  };
+
+  static_assert(listens_to<recording_listener, trade_message>);
+  static_assert(listens_to<recording_listener, order_executed_with_price_message>);
+  static_assert(!listens_to<recording_listener, net_order_imbalance_indicator_message>);
+  static_assert(!listens_to<null_listener, trade_message> && !listens_to_books<null_listener>);
+}
+
+TEST(MD_ITCH_FEED, listener)
+{
+  message_buffer messages;
+  messages.push(make_add(1, 1, 'B', 100, 100000));
+  messages.push(make_add(1, 2, 'B', 100, 99000));
+
+  trade_message trade{};
+  trade._header._type = message_type::TRADE_MESSAGE;
+  trade._header._stock_locate = 1;
+  trade._shares = 300;
+  messages.push(trade);
+
+  cross_trade_message cross{};
+  cross._header._type = message_type::CROSS_TRADE_MESSAGE;
+  cross._header._stock_locate = 2;
+  cross._shares = 5000;
+  messages.push(cross);
+
+  net_order_imbalance_indicator_message imbalance{};
+  imbalance._header._type = message_type::NET_ORDER_IMBALANCE_INDICATOR_MESSAGE;
+  imbalance._header._stock_locate = 2;
+  messages.push(imbalance);
+
+  order_executed_message executed{};
+  executed._header._type = message_type::ORDER_EXECUTED_MESSAGE;
+  executed._header._stock_locate = 1;
+  executed._order_reference_number = 1;
+  executed._executed_shares = 100;
+  messages.push(executed);
+
+  feed<buffer_receiver, recording_listener> itch{messages.receiver()};
+  itch.drain();
+
+  /* The first add and the execution that emptied the touch moved the top of book. The add behind it did not. */
+  recording_listener const &listener = itch.listener();
+  EXPECT_EQ(listener._updates, (std::vector<uint16_t>{1, 1}));
+  EXPECT_EQ(listener._best_bid, core::price_t::from_underlying(990000000));
+  EXPECT_EQ(listener._traded, 300);
+  EXPECT_EQ(listener._crossed, 5000);
+  EXPECT_EQ(listener._executed, 100);
+
+  /* Trades, crosses and imbalances never touch a book */
+  EXPECT_EQ(itch.active_books(), 1);
+}
+
+TEST(MD_ITCH_FEED, symbol_directory)
+{
+  message_buffer messages;
+  stock_directory_message directory = make_directory(3, "AAPL");
+  directory._round_lot_size = 100;
+  directory._etp_flag = 'N';
+  messages.push(directory);
+
+  directory = make_directory(4, "QQQ");
+  directory._round_lot_size = 100;
+  directory._etp_flag = 'Y';
+  directory._etp_leverage_factor = 1;
+  messages.push(directory);
+
+  feed<buffer_receiver> itch{messages.receiver()};
+  itch.drain();
+
+  symbol_directory const &symbols = itch.directory();
+  EXPECT_EQ(symbols.size(), 2);
+  EXPECT_EQ(symbols.locate("AAPL"), 3);
+  EXPECT_EQ(symbols.locate("MSFT"), symbol_directory::npos);
+  EXPECT_EQ(symbols[3].name(), "AAPL");
+  EXPECT_EQ(symbols[3]._round_lot_size, 100);
+  EXPECT_FALSE(symbols[3].etp());
+  EXPECT_TRUE(symbols[4].etp());
+  EXPECT_FALSE(symbols[5].known());
+}
+
+TEST(MD_ITCH_FEED, subscriptions)
+{
+  message_buffer messages;
+  messages.push(make_directory(1, "AAPL"));
+  messages.push(make_directory(2, "MSFT"));
+  messages.push(make_directory(3, "NVDA"));
+  messages.push(make_add(1, 1, 'B', 100, 100000));
+  messages.push(make_add(2, 2, 'B', 100, 100000));
+  messages.push(make_add(3, 3, 'B', 100, 100000));
+
+  feed<buffer_receiver> itch{messages.receiver()};
+  itch.subscribe("AAPL");
+  itch.subscribe("NVDA");
+
+  /* Only the subscribed books are built and maintained */
+  std::span<uint16_t const> changed = itch.drain();
+  EXPECT_EQ(std::vector<uint16_t>(changed.begin(), changed.end()), (std::vector<uint16_t>{1, 3}));
+  EXPECT_EQ(itch.active_books(), 2);
+  EXPECT_EQ(itch.book(2), nullptr);
+  EXPECT_FALSE(itch.subscribed(2));
+
+  /* Every symbol is still in the directory, so we can subscribe to one later */
+  EXPECT_EQ(itch.directory().locate("MSFT"), 2);
+  itch.subscribe("MSFT");
+  EXPECT_TRUE(itch.subscribed(2));
+}
+
+TEST(MD_ITCH_FEED, trading_state)
+{
+  message_buffer messages;
+
+  stock_trading_action_message action{};
+  action._header._type = message_type::STOCK_TRADING_ACTION_MESSAGE;
+  action._header._stock_locate = 5;
+  action._trading_state = 'T';
+  messages.push(action);
+
+  reg_sho_indicator_message reg_sho{};
+  reg_sho._header._type = message_type::REG_SHO_INDICATOR_MESSAGE;
+  reg_sho._header._stock_locate = 5;
+  reg_sho._reg_sho_action = '1';
+  messages.push(reg_sho);
+
+  operational_halt_message halt{};
+  halt._header._type = message_type::OPERATIONAL_HALT_MESSAGE;
+  halt._header._stock_locate = 5;
+  halt._market_code = 'Q';
+  halt._operational_halt_action = 'H';
+  messages.push(halt);
+
+  feed<buffer_receiver> itch{messages.receiver()};
+  EXPECT_EQ(itch.state(5)._status, trading_status::UNKNOWN);
+  EXPECT_FALSE(itch.state(5).tradeable());
+
+  itch.poll();
+  EXPECT_TRUE(itch.state(5).tradeable());
+  EXPECT_FALSE(itch.state(6).tradeable());
+
+  itch.poll();
+  EXPECT_TRUE(itch.state(5).short_sale_restricted());
+
+  /* An operational halt on NASDAQ stops trading without a change of trading state */
+  itch.poll();
+  EXPECT_EQ(itch.state(5)._status, trading_status::TRADING);
+  EXPECT_FALSE(itch.state(5).tradeable());
+
+  /* A LULD pause, extended by a collar, then lifted along with the operational halt */
+  message_buffer more;
+  action._trading_state = 'P';
+  more.push(action);
+
+  luld_auction_collar_message collar{};
+  collar._header._type = message_type::LULD_AUCTION_COLLAR_MESSAGE;
+  collar._header._stock_locate = 5;
+  more.push(collar);
+
+  halt._operational_halt_action = 'T';
+  more.push(halt);
+
+  action._trading_state = 'T';
+  more.push(action);
+
+  feed<buffer_receiver> resumed{more.receiver()};
+  resumed.poll();
+  resumed.poll();
+  EXPECT_TRUE(resumed.state(5).halted());
+  EXPECT_TRUE(resumed.state(5)._auction_collar);
+
+  resumed.drain();
+  EXPECT_TRUE(resumed.state(5).tradeable());
+  EXPECT_FALSE(resumed.state(5)._auction_collar);
+}
+
+TEST(MD_ITCH_FEED, published_quotes)
+{
+  message_buffer messages;
+  messages.push(make_add(1, 1, 'B', 100, 100000, 1000));
+  messages.push(make_add(1, 2, 'S', 300, 101000, 2000));
+  messages.push(make_add(1, 3, 'B', 100, 99000, 3000));
+
+  feed<buffer_receiver> itch{messages.receiver()};
+  itch.drain();
+
+  /* The add behind the touch is not published */
+  md::quote const quote = itch.book(1)->published().load();
+  EXPECT_EQ(quote._sequence, 2);
+  EXPECT_EQ(quote._timestamp, 2000);
+  EXPECT_EQ(quote._bid_price, core::price_t::from_underlying(1000000000));
+  EXPECT_EQ(quote._bid_quantity, 100);
+  EXPECT_EQ(quote._ask_price, core::price_t::from_underlying(1010000000));
+  EXPECT_EQ(quote._ask_quantity, 300);
+}
+
+TEST(MD_ITCH_FEED, snapshot)
+{
+  message_buffer messages;
+  messages.push(make_directory(1, "AAPL"));
+  messages.push(make_directory(2, "MSFT"));
+  messages.push(make_directory(3, "NVDA"));
+
+  /* Enough orders on each side to fill a queue and spill out of the window */
+  for (uint32_t id = 1; id <= 40; ++id)
+  {
+    bool const buy = id % 2 == 0;
+    messages.push(make_add(1, id, buy ? 'B' : 'S', 100 * id, static_cast<int32_t>(buy ? 100000 - id * 2000 : 100000 + id * 100)));
+    messages.push(make_add(3, 1000 + id, 'B', id, 50000));
+  }
+
+  stock_trading_action_message action{};
+  action._header._type = message_type::STOCK_TRADING_ACTION_MESSAGE;
+  action._header._stock_locate = 3;
+  action._trading_state = 'H';
+  messages.push(action);
+
+  feed<buffer_receiver> original{messages.receiver()};
+  original.subscribe("AAPL");
+  original.subscribe("NVDA");
+  original.drain();
+
+  std::filesystem::path const path = std::filesystem::temp_directory_path() / "zeus_test_feed_snapshot.bin";
+  original.save(path, 12345);
+
+  feed<buffer_receiver> restored{message_buffer{}.receiver()};
+  EXPECT_EQ(restored.restore(path), 12345);
+
+  /* Everything we know about each locate comes back as it was */
+  EXPECT_EQ(restored.active_books(), original.active_books());
+  EXPECT_EQ(restored.directory().locate("MSFT"), 2);
+  EXPECT_TRUE(restored.subscribed(1));
+  EXPECT_FALSE(restored.subscribed(2));
+  EXPECT_TRUE(restored.state(3).halted());
+
+  using level_t = std::pair<core::price_t, core::quantity_t>;
+  for (uint16_t locate : {1, 3})
+  {
+    for (core::order_side side : {core::order_side::BUY, core::order_side::SELL})
+    {
+      std::array<level_t, 32> expected{};
+      std::array<level_t, 32> actual{};
+      std::size_t const levels = original.book(locate)->depth(side, expected.size(), expected);
+      ASSERT_EQ(restored.book(locate)->depth(side, actual.size(), actual), levels);
+      EXPECT_TRUE(std::equal(expected.begin(), expected.begin() + levels, actual.begin()));
+    }
+    EXPECT_EQ(restored.book(locate)->live_orders(), original.book(locate)->live_orders());
+    EXPECT_EQ(restored.book(locate)->published().load()._sequence,
+              original.book(locate)->published().load()._sequence);
+  }
+  EXPECT_EQ(restored.book(3)->queue_position(1030), original.book(3)->queue_position(1030));
+
+  /* The restored books carry on from where they were */
+  message_buffer more;
+  order_delete_message remove{};
+  remove._header._type = message_type::ORDER_DELETE_MESSAGE;
+  remove._header._stock_locate = 3;
+  remove._order_reference_number = 1001;
+  more.push(remove);
+  more.push(make_add(3, 2000, 'B', 7, 50000));
+
+  feed<buffer_receiver> resumed{more.receiver()};
+  resumed.restore(path);
+  resumed.drain();
+  EXPECT_EQ(resumed.book(3)->queue_position(2000), (std::pair<std::size_t, core::quantity_t>{39, 819}));
+  EXPECT_EQ(resumed.book(3)->best_bid().second, 826);
+
+  std::filesystem::remove(path);
+}
+
+TEST(MD_ITCH_FEED, snapshot_rejects_other_files)
+{
+  std::filesystem::path const path = std::filesystem::temp_directory_path() / "zeus_test_feed_not_a_snapshot.bin";
+  {
+    std::ofstream file{path, std::ios::binary};
+    file << std::string(256, 'x');
+  }
+
+  feed<buffer_receiver> itch{message_buffer{}.receiver()};
+  EXPECT_THROW(itch.restore(path), std::runtime_error);
+
+  std::filesystem::remove(path);
+  EXPECT_THROW(itch.restore(path), std::runtime_error);
+}
+
+TEST(MD_ITCH_FEED, snapshot_rejects_bad_locates)
+{
+  message_buffer messages;
+  messages.push(make_directory(1, "AAPL"));
+  messages.push(make_directory(2, "MSFT"));
+  messages.push(make_add(1, 1, 'B', 100, 100000));
+  messages.push(make_add(2, 2, 'B', 100, 100000));
+
+  feed<buffer_receiver> original{messages.receiver()};
+  original.drain();
+
+  std::filesystem::path const path = std::filesystem::temp_directory_path() / "zeus_test_feed_bad_locates.bin";
+  original.save(path, 0);
+
+  std::vector<char> image(std::filesystem::file_size(path));
+  std::ifstream{path, std::ios::binary}.read(image.data(), static_cast<std::streamsize>(image.size()));
+
+  /* The header has the magic, the version, the number of locates and the position ahead of the sections */
+  uint64_t books = 0;
+  uint64_t symbols = 0;
+  std::memcpy(&books, image.data() + 24, sizeof(books));
+  std::memcpy(&symbols, image.data() + 56, sizeof(symbols));
+
+  /* Each saved book is its offset then its locate, and each saved symbol starts with its locate */
+  auto const rejects = [&](uint64_t at, uint64_t locate) {
+    std::vector<char> tampered = image;
+    std::memcpy(tampered.data() + at, &locate, sizeof(locate));
+    std::ofstream{path, std::ios::binary | std::ios::trunc}.write(tampered.data(),
+                                                                  static_cast<std::streamsize>(tampered.size()));
+
+    feed<buffer_receiver> restored{message_buffer{}.receiver()};
+    EXPECT_THROW(restored.restore(path), std::runtime_error);
+  };
+
+  rejects(books + 8, 70000);
+  rejects(books + 24, 1);
+  rejects(symbols, 70000);
+
+  std::filesystem::remove(path);
+}
+
+TEST(MD_ITCH_FEED, subscribe_mid_session)
+{
+  message_buffer messages;
+  messages.push(make_directory(1, "AAPL"));
+  messages.push(make_directory(2, "MSFT"));
+  messages.push(make_add(1, 1, 'B', 100, 100000));
+  messages.push(make_add(1, 2, 'B', 100, 100000));
+
+  /* Updates to the orders above, then a new order */
+  order_executed_message executed{};
+  executed._header._type = message_type::ORDER_EXECUTED_MESSAGE;
+  executed._header._stock_locate = 1;
+  executed._order_reference_number = 1;
+  executed._executed_shares = 100;
+  messages.push(executed);
+
+  order_cancel_message cancel{};
+  cancel._header._type = message_type::ORDER_CANCEL_MESSAGE;
+  cancel._header._stock_locate = 1;
+  cancel._order_reference_number = 2;
+  cancel._cancelled_shares = 50;
+  messages.push(cancel);
+
+  order_replace_message replace{};
+  replace._header._type = message_type::ORDER_REPLACE_MESSAGE;
+  replace._header._stock_locate = 1;
+  replace._original_order_reference_number = 2;
+  replace._new_order_reference_number = 3;
+  replace._shares = 10;
+  replace._price = 100100;
+  messages.push(replace);
+
+  order_delete_message remove{};
+  remove._header._type = message_type::ORDER_DELETE_MESSAGE;
+  remove._header._stock_locate = 1;
+  remove._order_reference_number = 3;
+  messages.push(remove);
+
+  messages.push(make_add(1, 4, 'B', 300, 99000));
+
+  feed<buffer_receiver> itch{messages.receiver()};
+  itch.subscribe("MSFT");
+  EXPECT_TRUE(itch.poll_n(4).empty());
+  EXPECT_EQ(itch.book(1), nullptr);
+
+  /* The adds went by before we followed the symbol, so the updates to them are for orders we never saw */
+  itch.subscribe("AAPL");
+  std::span<uint16_t const> changed = itch.drain();
+
+  /* Only the new add is applied. There was no book for the updates to go to before it. */
+  EXPECT_EQ(std::vector<uint16_t>(changed.begin(), changed.end()), (std::vector<uint16_t>{1}));
+  EXPECT_EQ(itch.unknown_messages(), 4);
+  md::book const *book = itch.book(1);
+  ASSERT_NE(book, nullptr);
+  EXPECT_EQ(book->unknown_orders(), 0);
+  EXPECT_EQ(book->live_orders(), 1);
+  EXPECT_EQ(book->best_bid().second, 300);
+}
+
+namespace
+{
+  /* Hears about the market as a whole, and trades in whatever it follows */
+  struct market_listener
+  {
+    void on_system_event(system_event_message const &message) { _events.push_back(message._event_code); }
+    void on_mwcb_status(mwcb_status_message const &message) { _breached = message._breached_level; }
+    void on_trade(trade_message const &message) { _trades.push_back(message._header._stock_locate); }
+
+    std::vector<system_event_message::event_code> _events;
+    uint8_t _breached{0};
+    std::vector<uint16_t> _trades;
+  };
+}
+
+TEST(MD_ITCH_FEED, subscriptions_keep_market_wide_messages)
+{
+  message_buffer messages;
+  messages.push(make_directory(1, "AAPL"));
+  messages.push(make_directory(2, "MSFT"));
+
+  system_event_message event{};
+  event._header._type = message_type::SYSTEM_EVENT_MESSAGE;
+  event._event_code = system_event_message::event_code::START_OF_MARKET_HOURS;
+  messages.push(event);
+
+  mwcb_status_message status{};
+  status._header._type = message_type::MWCB_STATUS_MESSAGE;
+  status._breached_level = '1';
+  messages.push(status);
+
+  trade_message trade{};
+  trade._header._type = message_type::TRADE_MESSAGE;
+  for (uint16_t locate : {1, 2})
+  {
+    trade._header._stock_locate = locate;
+    messages.push(trade);
+  }
+
+  feed<buffer_receiver, market_listener> itch{messages.receiver()};
+  itch.subscribe("AAPL");
+  itch.drain();
+
+  market_listener const &listener = itch.listener();
+  EXPECT_EQ(listener._events, (std::vector{system_event_message::event_code::START_OF_MARKET_HOURS}));
+  EXPECT_EQ(listener._breached, '1');
+  EXPECT_EQ(listener._trades, (std::vector<uint16_t>{1}));
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include "md/level_bitmap.h"
+
+using namespace zeus;
+
+TEST(MD_LEVEL_BITMAP, empty)
+{
+  md::level_bitmap bitmap{256};
+  EXPECT_EQ(bitmap.highest_below(255), md::level_bitmap::npos);
+  EXPECT_EQ(bitmap.lowest_above(0), md::level_bitmap::npos);
+}
+
+TEST(MD_LEVEL_BITMAP, within_word)
+{
+  md::level_bitmap bitmap{64};
+  bitmap.set(3);
+  bitmap.set(10);
+
+  EXPECT_EQ(bitmap.highest_below(10), 3);
+  EXPECT_EQ(bitmap.highest_below(11), 10);
+  EXPECT_EQ(bitmap.highest_below(3), md::level_bitmap::npos);
+  EXPECT_EQ(bitmap.lowest_above(3), 10);
+  EXPECT_EQ(bitmap.lowest_above(10), md::level_bitmap::npos);
+  EXPECT_EQ(bitmap.lowest_above(63), md::level_bitmap::npos);
+}
+
+TEST(MD_LEVEL_BITMAP, across_words)
+{
+  md::level_bitmap bitmap{md::level_bitmap::max_size};
+  bitmap.set(0);
+  bitmap.set(64);
+  bitmap.set(4095);
+
+  EXPECT_EQ(bitmap.highest_below(4095), 64);
+  EXPECT_EQ(bitmap.highest_below(64), 0);
+  EXPECT_EQ(bitmap.lowest_above(0), 64);
+  EXPECT_EQ(bitmap.lowest_above(64), 4095);
+  EXPECT_EQ(bitmap.lowest_above(63), 64);
+
+  /* Clearing the last bit of a word clears it from the summary too */
+  bitmap.clear(64);
+  EXPECT_FALSE(bitmap.test(64));
+  EXPECT_EQ(bitmap.lowest_above(0), 4095);
+  EXPECT_EQ(bitmap.highest_below(4095), 0);
+
+  bitmap.reset();
+  EXPECT_EQ(bitmap.lowest_above(0), md::level_bitmap::npos);
+}
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+#include "md/itch/line_arbitrator.h"
+#include "md/itch/mold_udp64.h"
+#include "md/itch/types.h"
+
+using namespace zeus;
+using namespace zeus::md::itch;
+
+namespace
+{
+  /* Hands out datagrams that have been queued up in memory */
+  class memory_packet_source
+  {
+  public:
+    void push(std::vector<std::byte> packet) { _packets.push_back(std::move(packet)); }
+
+    std::span<std::byte const> receive()
+    {
+      if (_packets.empty())
+      {
+        return {};
+      }
+
+      _current = std::move(_packets.front());
+      _packets.pop_front();
+      return _current;
+    }
+
+  private:
+    std::deque<std::vector<std::byte>> _packets;
+    std::vector<std::byte> _current;
+  };
+
+  /* Build a datagram carrying order deletes for a run of order ids, one per sequence number */
+  std::vector<std::byte> make_packet(char const *session, uint64_t sequence, uint16_t count)
+  {
+    mold_udp64_header header{};
+    std::memcpy(header._session, session, sizeof(header._session));
+    header._sequence_number = sequence;
+    header._message_count = count;
+
+    std::vector<std::byte> packet(sizeof(header));
+    std::memcpy(packet.data(), &header, sizeof(header));
+
+    for (uint64_t offset = 0; count != mold_udp64_header::end_of_session && offset < count; ++offset)
+    {
+      order_delete_message message{};
+      message._header._type = message_type::ORDER_DELETE_MESSAGE;
+      message._order_reference_number = sequence + offset;
+
+      packet.push_back(static_cast<std::byte>(sizeof(message) >> 8));
+      packet.push_back(static_cast<std::byte>(sizeof(message) & 0xFF));
+      auto const *bytes = reinterpret_cast<std::byte const *>(&message);
+      packet.insert(packet.end(), bytes, bytes + sizeof(message));
+    }
+
+    return packet;
+  }
+
+  /* Read every message available, and return the order ids, which match the sequence numbers */
+  template<typename Session>
+  std::vector<uint64_t> drain(Session &session)
+  {
+    std::vector<uint64_t> sequences;
+    for (std::span<std::byte const> message = session.next(); !message.empty(); message = session.next())
+    {
+      EXPECT_EQ(message.size(), sizeof(order_delete_message));
+      sequences.push_back(reinterpret_cast<order_delete_message const *>(message.data())->_order_reference_number);
+    }
+    return sequences;
+  }
+
+  constexpr char const session_id[] = "SESSION001";
+
+  /* The session slots straight into the feed as its receiver */
+  static_assert(receiver<mold_udp64_session<memory_packet_source>>);
+}
+
+TEST(MD_ITCH_MOLD_UDP64, in_order)
+{
+  auto source = std::make_unique<memory_packet_source>();
+  source->push(make_packet(session_id, 1, 3));
+  source->push(make_packet(session_id, 4, 0));
+  source->push(make_packet(session_id, 4, 2));
+
+  mold_udp64_session<memory_packet_source> session{std::move(source)};
+  EXPECT_EQ(drain(session), (std::vector<uint64_t>{1, 2, 3, 4, 5}));
+  EXPECT_EQ(session.expected_sequence(), 6);
+  EXPECT_EQ(session.gaps(), 0);
+}
+
+TEST(MD_ITCH_MOLD_UDP64, gaps)
+{
+  std::vector<mold_udp64_session<memory_packet_source>::gap> gaps;
+
+  auto source = std::make_unique<memory_packet_source>();
+  source->push(make_packet(session_id, 1, 2));
+  source->push(make_packet(session_id, 6, 2));
+  /* A heartbeat reveals that the tail of the stream was lost */
+  source->push(make_packet(session_id, 10, 0));
+  source->push(make_packet(session_id, 10, 1));
+
+  mold_udp64_session<memory_packet_source> session{std::move(source), [&gaps](auto const &gap) { gaps.push_back(gap); }};
+  EXPECT_EQ(drain(session), (std::vector<uint64_t>{1, 2, 6, 7, 10}));
+
+  ASSERT_EQ(gaps.size(), 2);
+  EXPECT_EQ(gaps[0]._from, 3);
+  EXPECT_EQ(gaps[0]._to, 6);
+  EXPECT_EQ(gaps[1]._from, 8);
+  EXPECT_EQ(gaps[1]._to, 10);
+  EXPECT_EQ(session.gaps(), 2);
+  EXPECT_EQ(session.missed(), 5);
+}
+
+TEST(MD_ITCH_MOLD_UDP64, throwing_gap_handler)
+{
+  auto source = std::make_unique<memory_packet_source>();
+  source->push(make_packet(session_id, 1, 1));
+  source->push(make_packet(session_id, 4, 2));
+
+  mold_udp64_session<memory_packet_source> session{std::move(source), [](auto const &) {
+    throw std::runtime_error{"Gap"};
+  }};
+  EXPECT_FALSE(session.next().empty());
+  EXPECT_THROW(session.next(), std::runtime_error);
+
+  /* The gap is accounted for, and the datagram that showed it up is still delivered */
+  EXPECT_EQ(session.missed(), 2);
+  EXPECT_EQ(drain(session), (std::vector<uint64_t>{4, 5}));
+}
+
+TEST(MD_ITCH_MOLD_UDP64, duplicates)
+{
+  auto source = std::make_unique<memory_packet_source>();
+  source->push(make_packet(session_id, 1, 3));
+  source->push(make_packet(session_id, 1, 3));
+  /* Overlaps the messages we have already seen */
+  source->push(make_packet(session_id, 2, 4));
+  /* Traffic from another session is ignored */
+  source->push(make_packet("SESSION002", 6, 1));
+  source->push(make_packet(session_id, 6, mold_udp64_header::end_of_session));
+
+  mold_udp64_session<memory_packet_source> session{std::move(source)};
+  EXPECT_EQ(drain(session), (std::vector<uint64_t>{1, 2, 3, 4, 5}));
+  EXPECT_EQ(session.gaps(), 0);
+  EXPECT_TRUE(session.ended());
+}
+
+TEST(MD_ITCH_MOLD_UDP64, truncated)
+{
+  auto source = std::make_unique<memory_packet_source>();
+  std::vector<std::byte> packet = make_packet(session_id, 1, 2);
+  packet.resize(packet.size() - 1);
+  source->push(std::move(packet));
+  source->push(make_packet(session_id, 3, 1));
+
+  mold_udp64_session<memory_packet_source> session{std::move(source)};
+
+  /* The rest of the truncated datagram is dropped without holding up the one behind it */
+  EXPECT_EQ(drain(session), (std::vector<uint64_t>{1, 3}));
+  EXPECT_EQ(session.truncated(), 1);
+  EXPECT_EQ(session.missed(), 1);
+}
+
+TEST(MD_ITCH_LINE_ARBITRATOR, fills_gaps_from_other_line)
+{
+  /* Each line loses a different packet */
+  auto a = std::make_unique<memory_packet_source>();
+  a->push(make_packet(session_id, 1, 2));
+  a->push(make_packet(session_id, 5, 2));
+  a->push(make_packet(session_id, 7, 2));
+
+  auto b = std::make_unique<memory_packet_source>();
+  b->push(make_packet(session_id, 1, 2));
+  b->push(make_packet(session_id, 3, 2));
+  b->push(make_packet(session_id, 5, 2));
+
+  using arbitrated = line_arbitrator<memory_packet_source>;
+  auto arbitrator = std::make_unique<arbitrated>(std::move(a), std::move(b));
+  arbitrated const &lines = *arbitrator;
+
+  mold_udp64_session<arbitrated> session{std::move(arbitrator)};
+  EXPECT_EQ(drain(session), (std::vector<uint64_t>{1, 2, 3, 4, 5, 6, 7, 8}));
+  EXPECT_EQ(session.gaps(), 0);
+
+  EXPECT_EQ(lines.expected_sequence(), 9);
+  EXPECT_EQ(lines.released_from_a(), 3);
+  EXPECT_EQ(lines.released_from_b(), 1);
+  EXPECT_EQ(lines.duplicates(), 2);
+  EXPECT_EQ(lines.abandoned(), 0);
+}
+
+TEST(MD_ITCH_LINE_ARBITRATOR, misaligned_packets)
+{
+  /* The lines need not split the stream at the same points */
+  auto a = std::make_unique<memory_packet_source>();
+  a->push(make_packet(session_id, 1, 3));
+  a->push(make_packet(session_id, 6, 2));
+
+  auto b = std::make_unique<memory_packet_source>();
+  b->push(make_packet(session_id, 1, 2));
+  b->push(make_packet(session_id, 3, 4));
+
+  mold_udp64_session<line_arbitrator<memory_packet_source>> session{
+    std::make_unique<line_arbitrator<memory_packet_source>>(std::move(a), std::move(b))};
+  EXPECT_EQ(drain(session), (std::vector<uint64_t>{1, 2, 3, 4, 5, 6, 7}));
+  EXPECT_EQ(session.gaps(), 0);
+}
+
+TEST(MD_ITCH_LINE_ARBITRATOR, gap_on_both_lines)
+{
+  auto a = std::make_unique<memory_packet_source>();
+  a->push(make_packet(session_id, 1, 2));
+  a->push(make_packet(session_id, 5, 2));
+
+  auto b = std::make_unique<memory_packet_source>();
+  b->push(make_packet(session_id, 1, 2));
+  b->push(make_packet(session_id, 5, 2));
+
+  using arbitrated = line_arbitrator<memory_packet_source>;
+  auto arbitrator = std::make_unique<arbitrated>(std::move(a), std::move(b));
+  arbitrated const &lines = *arbitrator;
+
+  mold_udp64_session<arbitrated> session{std::move(arbitrator)};
+  EXPECT_EQ(drain(session), (std::vector<uint64_t>{1, 2, 5, 6}));
+  EXPECT_EQ(session.gaps(), 1);
+  EXPECT_EQ(session.missed(), 2);
+  EXPECT_EQ(lines.abandoned(), 1);
+}
+
+TEST(MD_ITCH_LINE_ARBITRATOR, silent_line)
+{
+  /* The B line is down, so a hole on the A line can only be waited out */
+  auto a = std::make_unique<memory_packet_source>();
+  a->push(make_packet(session_id, 1, 2));
+  a->push(make_packet(session_id, 4, 1));
+
+  using arbitrated = line_arbitrator<memory_packet_source>;
+  arbitrated lines{std::move(a), std::make_unique<memory_packet_source>(), 1, 3};
+
+  EXPECT_FALSE(lines.receive().empty());
+  EXPECT_TRUE(lines.receive().empty());
+  EXPECT_TRUE(lines.receive().empty());
+  EXPECT_FALSE(lines.receive().empty());
+  EXPECT_EQ(lines.expected_sequence(), 5);
+  EXPECT_EQ(lines.abandoned(), 1);
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <unordered_map>
+
+#include "md/order_map.h"
+
+using namespace zeus;
+
+TEST(MD_ORDER_MAP, insert_find_erase)
+{
+  md::order_map<int64_t> map{4};
+
+  auto [value, inserted] = map.try_emplace(42, 7);
+  EXPECT_TRUE(inserted);
+  EXPECT_EQ(*value, 7);
+
+  /* A second insert does not overwrite */
+  auto [existing, reinserted] = map.try_emplace(42, 8);
+  EXPECT_FALSE(reinserted);
+  EXPECT_EQ(*existing, 7);
+
+  ASSERT_NE(map.find(42), nullptr);
+  EXPECT_EQ(*map.find(42), 7);
+  EXPECT_EQ(map.find(43), nullptr);
+  EXPECT_EQ(map.size(), 1);
+
+  EXPECT_TRUE(map.erase(42));
+  EXPECT_FALSE(map.erase(42));
+  EXPECT_EQ(map.find(42), nullptr);
+  EXPECT_EQ(map.size(), 0);
+}
+
+TEST(MD_ORDER_MAP, capacity)
+{
+  /* The table is sized so the requested number of orders fits without growing */
+  md::order_map<int64_t> map{1000};
+  std::size_t const capacity = map.capacity();
+  EXPECT_EQ(__builtin_popcountll(capacity), 1);
+
+  for (core::ordid_t id = 0; id < 1000; ++id)
+  {
+    map.try_emplace(id, static_cast<int64_t>(id));
+  }
+  EXPECT_EQ(map.capacity(), capacity);
+
+  /* Growing beyond it rehashes, keeping every entry */
+  for (core::ordid_t id = 1000; id < 10000; ++id)
+  {
+    map.try_emplace(id, static_cast<int64_t>(id));
+  }
+  EXPECT_GT(map.capacity(), capacity);
+
+  for (core::ordid_t id = 0; id < 10000; ++id)
+  {
+    ASSERT_NE(map.find(id), nullptr);
+    EXPECT_EQ(*map.find(id), static_cast<int64_t>(id));
+  }
+}
+
+TEST(MD_ORDER_MAP, backward_shift)
+{
+  /* Churn a small table against a reference to exercise long clusters and wrap-around */
+  md::order_map<int64_t> map{64};
+  std::unordered_map<core::ordid_t, int64_t> reference;
+  std::mt19937_64 rng{1234};
+
+  for (int step = 0; step < 100000; ++step)
+  {
+    core::ordid_t id = rng() % 96;
+    if (rng() % 2 == 0)
+    {
+      bool inserted = map.try_emplace(id, step).second;
+      EXPECT_EQ(inserted, reference.try_emplace(id, step).second);
+    }
+    else
+    {
+      EXPECT_EQ(map.erase(id), reference.erase(id) == 1);
+    }
+  }
+
+  EXPECT_EQ(map.size(), reference.size());
+  for (core::ordid_t id = 0; id < 96; ++id)
+  {
+    auto it = reference.find(id);
+    if (it == reference.end())
+    {
+      EXPECT_EQ(map.find(id), nullptr);
+    }
+    else
+    {
+      ASSERT_NE(map.find(id), nullptr);
+      EXPECT_EQ(*map.find(id), it->second);
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include "md/tick_table.h"
+
+using namespace zeus;
+
+TEST(MD_TICK_TABLE, single_band)
+{
+  md::tick_table ticks{core::price_t{0.01}};
+  EXPECT_EQ(ticks.index(core::price_t{0}), 0);
+  EXPECT_EQ(ticks.index(core::price_t{1.25}), 125);
+  EXPECT_EQ(ticks.price(125), core::price_t{1.25});
+}
+
+TEST(MD_TICK_TABLE, reg_nms)
+{
+  /* Sub-dollar prices trade in hundredths of a cent, everything else in cents */
+  md::tick_table ticks{
+    {._from = core::price_t{0}, ._tick_size = core::price_t{0.0001}},
+    {._from = core::price_t{1}, ._tick_size = core::price_t{0.01}}
+  };
+
+  EXPECT_EQ(ticks.index(core::price_t{0.9999}), 9999);
+  EXPECT_EQ(ticks.index(core::price_t{1}), 10000);
+  EXPECT_EQ(ticks.index(core::price_t{1.01}), 10001);
+  EXPECT_EQ(ticks.index(core::price_t{100}), 19900);
+
+  EXPECT_EQ(ticks.price(9999), core::price_t{0.9999});
+  EXPECT_EQ(ticks.price(10000), core::price_t{1});
+  EXPECT_EQ(ticks.price(19900), core::price_t{100});
+}
+
+TEST(MD_TICK_TABLE, many_bands)
+{
+  md::tick_table ticks{
+    {._from = core::price_t{0}, ._tick_size = core::price_t{0.001}},
+    {._from = core::price_t{1}, ._tick_size = core::price_t{0.005}},
+    {._from = core::price_t{5}, ._tick_size = core::price_t{0.01}},
+    {._from = core::price_t{10}, ._tick_size = core::price_t{0.05}}
+  };
+
+  /* Round trip every band boundary and a price within each band */
+  for (double price : {0.0, 0.5, 1.0, 2.5, 5.0, 7.5, 10.0, 12.5})
+  {
+    EXPECT_EQ(ticks.price(ticks.index(core::price_t{price})), core::price_t{price});
+  }
+
+  /* The ladder is continuous across the bands */
+  EXPECT_EQ(ticks.index(core::price_t{0.999}) + 1, ticks.index(core::price_t{1}));
+  EXPECT_EQ(ticks.index(core::price_t{4.995}) + 1, ticks.index(core::price_t{5}));
+  EXPECT_EQ(ticks.index(core::price_t{9.99}) + 1, ticks.index(core::price_t{10}));
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <optional>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "md/itch/udp_receiver.h"
+#include "md/itch/uring_receiver.h"
+
+using namespace zeus::md::itch;
+
+namespace
+{
+  constexpr char const group[] = "239.192.0.77";
+  constexpr char const loopback[] = "127.0.0.1";
+
+  /* Datagrams go on to the MoldUDP64 session, or the line arbitrator */
+  static_assert(packet_source<udp_receiver>);
+  static_assert(packet_source<uring_receiver>);
+
+  /* Publishes datagrams onto the multicast group over the loopback interface */
+  class publisher
+  {
+  public:
+    explicit publisher(uint16_t port) : _fd(::socket(AF_INET, SOCK_DGRAM, 0))
+    {
+      in_addr interface{};
+      ::inet_pton(AF_INET, loopback, &interface);
+      ::setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface));
+
+      unsigned char const enable = 1;
+      ::setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &enable, sizeof(enable));
+
+      _destination.sin_family = AF_INET;
+      _destination.sin_port = htons(port);
+      ::inet_pton(AF_INET, group, &_destination.sin_addr);
+    }
+
+    ~publisher() { ::close(_fd); }
+
+    bool send(std::span<std::byte const> packet)
+    {
+      return ::sendto(_fd, packet.data(), packet.size(), 0, reinterpret_cast<sockaddr const *>(&_destination),
+                      sizeof(_destination)) == static_cast<ssize_t>(packet.size());
+    }
+
+  private:
+    int _fd;
+    sockaddr_in _destination{};
+  };
+
+  /* Not every sandbox lets us join a multicast group on loopback */
+  template<typename Receiver = udp_receiver>
+  std::optional<Receiver> join(std::size_t batch_size)
+  {
+    try
+    {
+      return std::optional<Receiver>{std::in_place, group, 0, loopback, batch_size};
+    }
+    catch (std::runtime_error const &)
+    {
+      return std::nullopt;
+    }
+  }
+}
+
+TEST(MD_ITCH_UDP_RECEIVER, batches)
+{
+  std::optional<udp_receiver> receiver = join(16);
+  if (!receiver)
+  {
+    GTEST_SKIP() << "Multicast is not available on loopback";
+  }
+
+  publisher sender{receiver->port()};
+  for (uint8_t index = 0; index < 10; ++index)
+  {
+    std::array<std::byte, 32> packet{};
+    packet[0] = static_cast<std::byte>(index);
+    if (!sender.send({packet.data(), 1u + index}))
+    {
+      GTEST_SKIP() << "Multicast is not routable on loopback";
+    }
+  }
+
+  /* Loopback delivers synchronously, so everything is already queued and a single syscall picks it all up */
+  for (uint8_t index = 0; index < 10; ++index)
+  {
+    std::span<std::byte const> packet = receiver->receive();
+    ASSERT_EQ(packet.size(), 1u + index);
+    EXPECT_EQ(packet[0], static_cast<std::byte>(index));
+    EXPECT_NE(receiver->timestamp(), 0);
+  }
+
+  EXPECT_TRUE(receiver->receive().empty());
+  EXPECT_EQ(receiver->batches(), 1);
+  EXPECT_EQ(receiver->packets(), 10);
+  EXPECT_EQ(receiver->truncated(), 0);
+}
+
+TEST(MD_ITCH_UDP_RECEIVER, batch_limit)
+{
+  std::optional<udp_receiver> receiver = join(4);
+  if (!receiver)
+  {
+    GTEST_SKIP() << "Multicast is not available on loopback";
+  }
+
+  publisher sender{receiver->port()};
+  std::array<std::byte, 8> packet{};
+  for (int index = 0; index < 10; ++index)
+  {
+    if (!sender.send(packet))
+    {
+      GTEST_SKIP() << "Multicast is not routable on loopback";
+    }
+  }
+
+  std::size_t received{0};
+  while (!receiver->receive().empty())
+  {
+    ++received;
+  }
+
+  EXPECT_EQ(received, 10);
+  EXPECT_EQ(receiver->batches(), 3);
+}
+
+TEST(MD_ITCH_URING_RECEIVER, multishot)
+{
+  std::optional<uring_receiver> receiver = join<uring_receiver>(16);
+  if (!receiver)
+  {
+    GTEST_SKIP() << "io_uring or multicast is not available";
+  }
+
+  publisher sender{receiver->port()};
+  for (uint8_t index = 0; index < 10; ++index)
+  {
+    std::array<std::byte, 32> packet{};
+    packet[0] = static_cast<std::byte>(index);
+    if (!sender.send({packet.data(), 1u + index}))
+    {
+      GTEST_SKIP() << "Multicast is not routable on loopback";
+    }
+  }
+
+  /* Every datagram comes off the completion ring, without another submission */
+  for (uint8_t index = 0; index < 10; ++index)
+  {
+    std::span<std::byte const> packet = receiver->receive();
+    ASSERT_EQ(packet.size(), 1u + index);
+    EXPECT_EQ(packet[0], static_cast<std::byte>(index));
+  }
+
+  EXPECT_TRUE(receiver->receive().empty());
+  EXPECT_EQ(receiver->packets(), 10);
+  EXPECT_EQ(receiver->submissions(), 1);
+}
+
+TEST(MD_ITCH_URING_RECEIVER, buffer_exhaustion)
+{
+  std::optional<uring_receiver> receiver = join<uring_receiver>(4);
+  if (!receiver)
+  {
+    GTEST_SKIP() << "io_uring or multicast is not available";
+  }
+
+  publisher sender{receiver->port()};
+  std::array<std::byte, 8> packet{};
+  for (int index = 0; index < 10; ++index)
+  {
+    if (!sender.send(packet))
+    {
+      GTEST_SKIP() << "Multicast is not routable on loopback";
+    }
+  }
+
+  /* Once the kernel runs out of buffers the recv stops, and has to be rearmed to pick up the rest */
+  std::size_t received{0};
+  for (int poll = 0; poll < 1000 && received < 10; ++poll)
+  {
+    received += !receiver->receive().empty();
+  }
+
+  EXPECT_EQ(received, 10);
+  EXPECT_GT(receiver->submissions(), 1);
+}
\ No newline at end of file
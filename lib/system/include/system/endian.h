@@ -0,0 +1,67 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+
+namespace zeus::system
+{
+  /** Reverse the bytes of an integer. GCC and Clang lower this to a single bswap, or movbe when it is fused with a load. */
+  template<std::integral T>
+  [[nodiscard]] constexpr T byteswap(T value) noexcept
+  {
+    if constexpr (sizeof(T) == 1)
+    {
+      return value;
+    }
+    else if constexpr (sizeof(T) == 2)
+    {
+      return static_cast<T>(__builtin_bswap16(static_cast<uint16_t>(value)));
+    }
+    else if constexpr (sizeof(T) == 4)
+    {
+      return static_cast<T>(__builtin_bswap32(static_cast<uint32_t>(value)));
+    }
+    else
+    {
+      static_assert(sizeof(T) == 8, "Unsupported integer width.");
+      return static_cast<T>(__builtin_bswap64(static_cast<uint64_t>(value)));
+    }
+  }
+
+  /**
+   * An integer stored in network byte order, for overlaying on wire formats.
+   *
+   * The bytes are left exactly as they arrived, and only swapped when the value is read. A handler that never touches a
+   * field never pays for it.
+   */
+  template<std::integral T>
+  class big_endian
+  {
+  public:
+    using value_type = T;
+
+    big_endian() = default;
+
+    /***/
+    constexpr big_endian(T value) noexcept : _raw(byteswap(value))
+    {
+    }
+
+    /***/
+    constexpr operator T() const noexcept { return byteswap(_raw); }
+
+    /** The value in host byte order */
+    [[nodiscard]] constexpr T get() const noexcept { return byteswap(_raw); }
+
+  private:
+    /** \brief The value exactly as it appears on the wire */
+    T _raw;
+  } __attribute__((packed));
+
+  using be_u16 = big_endian<uint16_t>;
+  using be_u32 = big_endian<uint32_t>;
+  using be_u64 = big_endian<uint64_t>;
+  using be_i32 = big_endian<int32_t>;
+
+  static_assert(sizeof(be_u64) == sizeof(uint64_t) && alignof(be_u64) == 1);
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <xmmintrin.h>
+
+#include "system/utilities.h"
+
+namespace zeus::thread
+{
+  /**
+   * Publishes a value from a single writer to any number of readers. The writer never waits, and readers retry if they
+   * raced with a write.
+   *
+   * The value is held as relaxed atomic words, so a reader that overlaps a write reads torn data rather than racing, and
+   * then throws it away. The sequence is odd while a write is in progress. Small values share a cache line with it.
+   */
+  template<typename T>
+  class alignas(64) seqlock
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "A seqlock copies its value byte by byte.");
+
+  private:
+    static constexpr std::size_t _words{(sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t)};
+
+  public:
+    seqlock() : seqlock(T{})
+    {
+    }
+
+    /***/
+    explicit seqlock(T const &value) noexcept
+    {
+      _write(value);
+    }
+
+    /** Copies the current value, but not the readers. Only safe while nobody is writing to the other. */
+    seqlock(seqlock const &other) noexcept : seqlock(other.load())
+    {
+    }
+
+    seqlock &operator=(seqlock const &other) noexcept
+    {
+      store(other.load());
+      return *this;
+    }
+
+    /** Publish a value. Only one thread may write. */
+    void store(T const &value) noexcept
+    {
+      uint64_t const sequence = _sequence.load(std::memory_order_relaxed);
+      _sequence.store(sequence + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+
+      _write(value);
+
+      _sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /** Take a consistent copy of the value, from any thread */
+    [[nodiscard]] T load() const noexcept
+    {
+      std::array<uint64_t, _words> words;
+      while (true)
+      {
+        uint64_t const before = _sequence.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < _words; ++i)
+        {
+          words[i] = _value[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        /* Nothing was written while we were reading */
+        if (__likely((before & 1) == 0 && before == _sequence.load(std::memory_order_relaxed)))
+        {
+          break;
+        }
+        _mm_pause();
+      }
+
+      /* T is trivially copyable, which is all that copying its bytes requires */
+      T value;
+      std::memcpy(static_cast<void *>(&value), words.data(), sizeof(T));
+      return value;
+    }
+
+    /** The number of values published so far */
+    [[nodiscard]] uint64_t version() const noexcept { return _sequence.load(std::memory_order_acquire) / 2; }
+
+  private:
+    /***/
+    void _write(T const &value) noexcept
+    {
+      std::array<uint64_t, _words> words{};
+      std::memcpy(words.data(), &value, sizeof(T));
+      for (std::size_t i = 0; i < _words; ++i)
+      {
+        _value[i].store(words[i], std::memory_order_relaxed);
+      }
+    }
+
+  private:
+    /** \brief Odd while the writer is part way through a store */
+    std::atomic<uint64_t> _sequence{0};
+
+    /** \brief The value, a word at a time */
+    std::array<std::atomic<uint64_t>, _words> _value{};
+  };
+}
\ No newline at end of file
@@ -1,8 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
-#include <filesystem>
 #include <cstring>
+#include <span>
 #include <sys/mman.h>
 #include <unistd.h>
 
@@ -35,7 +36,7 @@ namespace zeus::thread
       {
         if(static_cast<bool>(*this))
         {
-          _rb._begin.fetch_add(sizeof(T), std::memory_order_relaxed);
+          _rb._begin.fetch_add(sizeof(T), std::memory_order_release);
         }
       }
 
@@ -56,15 +57,14 @@ namespace zeus::thread
     {
       /* First mmap, used purely to reserve the virtual address space */
       _buffer = reinterpret_cast<std::byte*>(::mmap(nullptr, 2 * N, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
-      if(_buffer == nullptr)
+      if(_buffer == MAP_FAILED)
       {
         zeus::system::throw_runtime_error("spsc_circular_buffer", __func__, "Failed to create initial mapping.");
       }
 
       /* TODO(jhannah): Enable option to use hugepages */
-      /* Open a file used to capture some underlying memory */
-      std::filesystem::path tmpname{std::tmpnam(nullptr)};
-      int fd = memfd_create(tmpname.filename().string().data(), MFD_CLOEXEC);
+      /* Open a file used to capture some underlying memory. The name is only a label, so it need not be unique. */
+      int fd = memfd_create("spsc_circular_buffer", MFD_CLOEXEC);
       if(fd == -1)
       {
         std::string msg = std::string{"Failed to create file descriptor: "} + std::strerror(errno);
@@ -79,9 +79,10 @@ namespace zeus::thread
         zeus::system::throw_runtime_error("spsc_circular_buffer", __func__, std::move(msg));
       }
 
-      /* Now create the two underlying, contiguous mappings */
-      if(::mmap(_buffer, N,PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_POPULATE | MAP_FIXED, fd, 0) == nullptr ||
-         ::mmap(_buffer + N, N, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_POPULATE | MAP_FIXED, fd, 0) == nullptr)
+      /* Now create the two underlying, contiguous mappings. They must be shared, otherwise each mapping gets its own
+       * private copy of the pages on first write and the second half no longer mirrors the first. */
+      if(::mmap(_buffer, N,PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE | MAP_FIXED, fd, 0) == MAP_FAILED ||
+         ::mmap(_buffer + N, N, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE | MAP_FIXED, fd, 0) == MAP_FAILED)
       {
         std::string msg = std::string{"Failed to create magic mapping: "} + std::strerror(errno);
         zeus::system::throw_runtime_error("spsc_circular_buffer", __func__, std::move(msg));
@@ -109,13 +110,46 @@ namespace zeus::thread
 
     void write(T elem)
     {
-      if (__likely(_end.load(std::memory_order_relaxed) - _begin.load(std::memory_order_relaxed) <= N - sizeof(T)))
+      if (__likely(_end.load(std::memory_order_relaxed) - _begin.load(std::memory_order_acquire) <= N - sizeof(T)))
       {
         std::memcpy(_buffer + _end.load(std::memory_order_relaxed) % N, std::addressof(elem), sizeof(T));
-        _end.fetch_add(sizeof(T), std::memory_order_relaxed);
+        _end.fetch_add(sizeof(T), std::memory_order_release);
       }
     }
 
+    /**
+     * Producer side of the raw byte interface, for variable length records. Because the buffer is mapped twice back to
+     * back, the free space is always one contiguous region, even when it wraps.
+     *
+     * @param size The most bytes the producer wants to write
+     * @returns Contiguous free space, which may be smaller than requested or empty if the buffer is full
+     */
+    std::span<std::byte> prepare(std::size_t size) noexcept
+    {
+      std::size_t const end = _end.load(std::memory_order_relaxed);
+      std::size_t const free = N - (end - _begin.load(std::memory_order_acquire));
+      return {_buffer + end % N, std::min(size, free)};
+    }
+
+    /** Publish bytes written into the space returned by prepare() */
+    void commit(std::size_t size) noexcept
+    {
+      _end.store(_end.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+    /** Consumer side of the raw byte interface. Everything published so far, as one contiguous region. */
+    std::span<std::byte const> peek() const noexcept
+    {
+      std::size_t const begin = _begin.load(std::memory_order_relaxed);
+      return {_buffer + begin % N, _end.load(std::memory_order_acquire) - begin};
+    }
+
+    /** Hand bytes returned by peek() back to the producer */
+    void consume(std::size_t size) noexcept
+    {
+      _begin.store(_begin.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
     void reset()
     {
       _begin.store(0, std::memory_order_release);
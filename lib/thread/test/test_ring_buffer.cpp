@@ -25,4 +25,35 @@ TEST(THREAD_RING_BUFFER, initialisation)
     spsc_circular_buffer<uint64_t, 4096>::handle elem = rb.read();
     EXPECT_FALSE(static_cast<bool>(elem));
   }
+}
+
+TEST(THREAD_RING_BUFFER, contiguous_bytes)
+{
+  spsc_circular_buffer<std::byte, 4096> rb;
+
+  /* Move the cursors close to the end of the buffer */
+  rb.commit(rb.prepare(4000).size());
+  rb.consume(rb.peek().size());
+  EXPECT_TRUE(rb.empty());
+
+  /* A write across the end of the buffer is still one contiguous region, on both sides */
+  std::span<std::byte> space = rb.prepare(200);
+  ASSERT_EQ(space.size(), 200);
+  for (std::size_t i = 0; i < space.size(); ++i)
+  {
+    space[i] = static_cast<std::byte>(i);
+  }
+  rb.commit(space.size());
+
+  std::span<std::byte const> data = rb.peek();
+  ASSERT_EQ(data.size(), 200);
+  for (std::size_t i = 0; i < data.size(); ++i)
+  {
+    EXPECT_EQ(data[i], static_cast<std::byte>(i));
+  }
+
+  /* The producer can never get more than the free space */
+  EXPECT_EQ(rb.prepare(8192).size(), 4096 - 200);
+  rb.consume(100);
+  EXPECT_EQ(rb.prepare(8192).size(), 4096 - 100);
 }
\ No newline at end of file
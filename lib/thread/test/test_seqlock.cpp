@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "thread/seqlock.h"
+
+using namespace zeus::thread;
+
+namespace
+{
+  /* Every field holds the same value, so a torn read is easy to spot */
+  struct payload
+  {
+    uint64_t _a;
+    uint64_t _b;
+    uint64_t _c;
+    uint32_t _d;
+  };
+}
+
+TEST(THREAD_SEQLOCK, store_and_load)
+{
+  seqlock<payload> slot;
+  EXPECT_EQ(slot.version(), 0);
+  EXPECT_EQ(slot.load()._a, 0);
+
+  slot.store({1, 2, 3, 4});
+  payload const value = slot.load();
+  EXPECT_EQ(value._a, 1);
+  EXPECT_EQ(value._d, 4);
+  EXPECT_EQ(slot.version(), 1);
+
+  static_assert(alignof(seqlock<payload>) == 64 && sizeof(seqlock<payload>) == 64);
+}
+
+TEST(THREAD_SEQLOCK, readers_never_see_a_torn_value)
+{
+  constexpr uint64_t writes{200000};
+  seqlock<payload> slot;
+
+  std::vector<std::thread> readers;
+  std::atomic<bool> torn{false};
+  for (int reader = 0; reader < 2; ++reader)
+  {
+    readers.emplace_back([&] {
+      uint64_t last{0};
+      while (last < writes)
+      {
+        payload const value = slot.load();
+        if (value._a != value._b || value._b != value._c || value._c != value._d || value._a < last)
+        {
+          torn = true;
+          return;
+        }
+        last = value._a;
+      }
+    });
+  }
+
+  for (uint64_t i = 1; i <= writes; ++i)
+  {
+    slot.store({i, i, i, static_cast<uint32_t>(i)});
+  }
+
+  for (std::thread &reader : readers)
+  {
+    reader.join();
+  }
+  EXPECT_FALSE(torn);
+}
\ No newline at end of file